@@ -0,0 +1,446 @@
+// Micro-benchmarks for the simulation engine.
+//
+// Every benchmark is calibrated until one sample takes at least --min-time
+// milliseconds, warmed up, then timed for --repetitions samples with the same
+// iteration count. Results are reported per operation as min, median, mean and
+// standard deviation, as a table or, with --json, as one JSON document.
+#include "Simulation.h"
+#include "SnapshotStore.h"
+#include "globals.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <unistd.h>
+
+// Set by `make bench` to the flags the benchmark and engine were compiled with
+#ifndef BENCH_COMPILE_FLAGS
+#define BENCH_COMPILE_FLAGS "unknown"
+#endif
+
+using namespace std;
+
+namespace
+{
+    // One timed sample: the benchmark does its setup, then times iterations operations
+    class Run
+    {
+    public:
+        explicit Run(std::size_t iterations) : iterations(iterations), begin(), end() {}
+        std::size_t getIterations() const { return iterations; }
+        void start() { begin = std::chrono::steady_clock::now(); }
+        void stop() { end = std::chrono::steady_clock::now(); }
+        double getNanoseconds() const { return std::chrono::duration<double, std::nano>(end - begin).count(); }
+
+    private:
+        std::size_t iterations;
+        std::chrono::steady_clock::time_point begin;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    typedef void (*BenchmarkFunction)(Run &run, int parameter);
+
+    struct Benchmark
+    {
+        string name;
+        BenchmarkFunction function;
+        int parameter;
+    };
+
+    struct Result
+    {
+        string name;
+        std::size_t iterations;
+        vector<double> samples; // nanoseconds per operation
+        double min, median, mean, stddev;
+    };
+
+    // Swallows what the simulation prints while it is being measured
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+    };
+
+    const int SETTLEMENT_COUNT = 100;
+    const int FACILITY_COUNT = 200;
+    const int PARSE_LINES = 20000;
+    const char *POLICIES[] = {"naiv", "bal", "eco", "sus"};
+
+    string configPath;      // settlements and facilities, no plans
+    string largeConfigPath; // PARSE_LINES lines of settlements, facilities and plans
+    WorkerPool *workerPool = nullptr;
+
+    string writeConfig(int settlements, int facilities, int plans)
+    {
+        char path[] = "/tmp/simulation-bench-XXXXXX";
+        int descriptor = mkstemp(path);
+        if (descriptor == -1)
+        {
+            throw std::runtime_error("Failed to create a benchmark config file.");
+        }
+        close(descriptor);
+        std::ofstream out(path);
+        for (int i = 0; i < settlements; i++)
+        {
+            out << "settlement s" << i << ' ' << i % 3 << '\n';
+        }
+        for (int i = 0; i < facilities; i++)
+        {
+            out << "facility f" << i << ' ' << i % 3 << ' ' << 1 + i % 5 << ' ' << i % 4 << ' ' << (i / 3) % 4 << ' ' << (i / 7) % 4 << '\n';
+        }
+        for (int i = 0; i < plans; i++)
+        {
+            out << "plan s" << i % settlements << ' ' << POLICIES[i % 4] << '\n';
+        }
+        return path;
+    }
+
+    SelectionPolicy *createPolicy(int kind)
+    {
+        switch (kind)
+        {
+        case 0:
+            return new NaiveSelection();
+        case 1:
+            return new BalancedSelection(0, 0, 0);
+        case 2:
+            return new EconomySelection();
+        default:
+            return new SustainabilitySelection();
+        }
+    }
+
+    // A simulation over the benchmark config with planCount plans, policies in turn
+    Simulation *createSimulation(int planCount)
+    {
+        Simulation *simulation = new Simulation(configPath, workerPool);
+        for (int i = 0; i < planCount; i++)
+        {
+            const Settlement &settlement = simulation->getSettlement("s" + std::to_string(i % SETTLEMENT_COUNT));
+            simulation->addPlan(settlement, createPolicy(i % 4));
+        }
+        return simulation;
+    }
+
+    FacilityCatalog createCatalog()
+    {
+        FacilityCatalog catalog;
+        for (int i = 0; i < FACILITY_COUNT; i++)
+        {
+            catalog.push_back(FacilityType("f" + std::to_string(i), static_cast<FacilityCategory>(i % 3), 1 + i % 5, i % 4, (i / 3) % 4, (i / 7) % 4));
+        }
+        return catalog;
+    }
+
+    void benchPlanStep(Run &run, int policy)
+    {
+        FacilityCatalog catalog = createCatalog();
+        Settlement settlement("s", SettlementType::METROPOLIS);
+        Plan plan(0, settlement, createPolicy(policy));
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            plan.step(catalog);
+        }
+        run.stop();
+    }
+
+    void benchSelectFacility(Run &run, int policy)
+    {
+        FacilityCatalog catalog = createCatalog();
+        SelectionPolicy *selectionPolicy = createPolicy(policy);
+        std::size_t checksum = 0;
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            checksum += selectionPolicy->selectFacility(catalog).getCost();
+        }
+        run.stop();
+        delete selectionPolicy;
+        if (checksum == 0)
+        {
+            cerr << "unexpected checksum\n"; // keeps the selections from being optimized away
+        }
+    }
+
+    void benchSimulationStep(Run &run, int planCount)
+    {
+        Simulation *simulation = createSimulation(planCount);
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            simulation->step(1);
+        }
+        run.stop();
+        delete simulation;
+    }
+
+    void benchBackup(Run &run, int planCount)
+    {
+        Simulation *simulation = createSimulation(planCount);
+        simulation->step(10);
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            simulation->backup("bench");
+        }
+        run.stop();
+        delete simulation;
+    }
+
+    void benchRestore(Run &run, int planCount)
+    {
+        Simulation *simulation = createSimulation(planCount);
+        simulation->step(10);
+        simulation->backup("bench");
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            simulation->restore("bench");
+        }
+        run.stop();
+        delete simulation;
+    }
+
+    void benchParseConfigFile(Run &run, int)
+    {
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            Simulation simulation(largeConfigPath, workerPool);
+        }
+        run.stop();
+    }
+
+    void benchActionHandler(Run &run, int)
+    {
+        static const string commands[] = {"planStatus 99999", "settlement s0 0", "changePlanPoliciy 0 naiv", "log tail 0", "unknown command"};
+        const std::size_t commandCount = sizeof(commands) / sizeof(commands[0]);
+        Simulation *simulation = createSimulation(10);
+        simulation->setLogLimit(1024);
+        run.start();
+        for (std::size_t i = 0; i < run.getIterations(); i++)
+        {
+            simulation->actionHandler(commands[i % commandCount]);
+        }
+        run.stop();
+        delete simulation;
+    }
+
+    vector<Benchmark> getBenchmarks()
+    {
+        vector<Benchmark> benchmarks;
+        for (int policy = 0; policy < 4; policy++)
+        {
+            benchmarks.push_back(Benchmark{string("Plan::step/") + POLICIES[policy], benchPlanStep, policy});
+        }
+        for (int policy = 0; policy < 4; policy++)
+        {
+            benchmarks.push_back(Benchmark{string("SelectionPolicy::selectFacility/") + POLICIES[policy], benchSelectFacility, policy});
+        }
+        for (int plans : {10, 100, 1000, 10000})
+        {
+            benchmarks.push_back(Benchmark{"Simulation::step/" + std::to_string(plans), benchSimulationStep, plans});
+        }
+        for (int plans : {100, 10000})
+        {
+            benchmarks.push_back(Benchmark{"Simulation::backup/" + std::to_string(plans), benchBackup, plans});
+            benchmarks.push_back(Benchmark{"Simulation::restore/" + std::to_string(plans), benchRestore, plans});
+        }
+        benchmarks.push_back(Benchmark{"Simulation::parseConfigFile/" + std::to_string(PARSE_LINES), benchParseConfigFile, 0});
+        benchmarks.push_back(Benchmark{"Simulation::actionHandler/mixed", benchActionHandler, 0});
+        return benchmarks;
+    }
+
+    Result measure(const Benchmark &benchmark, double minNanoseconds, int repetitions)
+    {
+        // Double the iteration count until one sample is long enough; this also warms up
+        std::size_t iterations = 1;
+        for (;;)
+        {
+            Run run(iterations);
+            benchmark.function(run, benchmark.parameter);
+            if (run.getNanoseconds() >= minNanoseconds || iterations >= (std::size_t(1) << 30))
+            {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        Result result{benchmark.name, iterations, vector<double>(), 0, 0, 0, 0};
+        for (int i = 0; i < repetitions; i++)
+        {
+            Run run(iterations);
+            benchmark.function(run, benchmark.parameter);
+            result.samples.push_back(run.getNanoseconds() / iterations);
+        }
+
+        vector<double> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+        std::size_t count = sorted.size();
+        result.min = sorted[0];
+        result.median = count % 2 == 1 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+        double sum = 0;
+        for (double sample : sorted)
+        {
+            sum += sample;
+        }
+        result.mean = sum / count;
+        double squares = 0;
+        for (double sample : sorted)
+        {
+            squares += (sample - result.mean) * (sample - result.mean);
+        }
+        result.stddev = count > 1 ? std::sqrt(squares / (count - 1)) : 0;
+        return result;
+    }
+
+    void printTable(std::ostream &out, const vector<Result> &results)
+    {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-40s %12s %14s %14s %14s %10s\n", "Benchmark", "Iterations", "Min ns/op", "Median ns/op", "Mean ns/op", "Stddev %");
+        out << line;
+        for (const Result &result : results)
+        {
+            std::snprintf(line, sizeof(line), "%-40s %12zu %14.1f %14.1f %14.1f %10.2f\n", result.name.c_str(), result.iterations,
+                          result.min, result.median, result.mean, result.mean > 0 ? 100 * result.stddev / result.mean : 0.0);
+            out << line;
+        }
+    }
+
+    void printJson(std::ostream &out, const vector<Result> &results, int repetitions, int threads)
+    {
+#ifdef __OPTIMIZE__
+        const bool optimized = true;
+#else
+        const bool optimized = false;
+#endif
+        out << "{\n  \"unit\": \"ns/op\",\n  \"compileFlags\": \"" << BENCH_COMPILE_FLAGS << "\",\n  \"optimized\": "
+            << (optimized ? "true" : "false") << ",\n  \"repetitions\": " << repetitions << ",\n  \"threads\": " << threads
+            << ",\n  \"benchmarks\": [";
+        out.precision(17);
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const Result &result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                << ", \"min\": " << result.min << ", \"median\": " << result.median << ", \"mean\": " << result.mean
+                << ", \"stddev\": " << result.stddev << ", \"samples\": [";
+            for (std::size_t j = 0; j < result.samples.size(); j++)
+            {
+                out << (j == 0 ? "" : ", ") << result.samples[j];
+            }
+            out << "]}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    const char *USAGE = "usage: benchmark [--filter <text>] [--repetitions <count>] [--min-time <milliseconds>] "
+                        "[--threads <count>] [--json] [--list]";
+}
+
+int main(int argc, char **argv)
+{
+    string filter = "";
+    int repetitions = 10;
+    double minTime = 50;
+    int threads = 1;
+    bool json = false;
+    bool list = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--filter" && hasValue)
+        {
+            filter = argv[++i]; // runs the benchmarks whose name contains it
+        }
+        else if (option == "--repetitions" && hasValue)
+        {
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (option == "--min-time" && hasValue)
+        {
+            minTime = std::stod(argv[++i]);
+        }
+        else if (option == "--threads" && hasValue)
+        {
+            threads = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (option == "--json")
+        {
+            json = true;
+        }
+        else if (option == "--list")
+        {
+            list = true;
+        }
+        else
+        {
+            cerr << USAGE << endl;
+            return 1;
+        }
+    }
+
+    vector<Benchmark> benchmarks;
+    for (const Benchmark &benchmark : getBenchmarks())
+    {
+        if (benchmark.name.find(filter) != string::npos)
+        {
+            benchmarks.push_back(benchmark);
+        }
+    }
+    if (list)
+    {
+        for (const Benchmark &benchmark : benchmarks)
+        {
+            cout << benchmark.name << '\n';
+        }
+        return 0;
+    }
+
+    configPath = writeConfig(SETTLEMENT_COUNT, FACILITY_COUNT, 0);
+    largeConfigPath = writeConfig(PARSE_LINES / 4, PARSE_LINES / 4, PARSE_LINES / 2);
+    WorkerPool pool(threads);
+    workerPool = &pool;
+    snapshotStore = new SnapshotStore(0);
+
+    // The engine prints through cout; results go to the real stdout instead
+    std::ostream results(cout.rdbuf());
+    NullBuffer discard;
+    cout.rdbuf(&discard);
+
+    vector<Result> measured;
+    for (const Benchmark &benchmark : benchmarks)
+    {
+        if (!json)
+        {
+            cerr << "running " << benchmark.name << '\n';
+        }
+        measured.push_back(measure(benchmark, minTime * 1e6, repetitions));
+    }
+
+    if (json)
+    {
+        printJson(results, measured, repetitions, threads);
+    }
+    else
+    {
+        printTable(results, measured);
+    }
+    results.flush();
+    cout.rdbuf(results.rdbuf());
+
+    delete snapshotStore;
+    snapshotStore = nullptr;
+    std::remove(configPath.c_str());
+    std::remove(largeConfigPath.c_str());
+    return 0;
+}
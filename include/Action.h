@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include "Simulation.h"
+#include "ActionLog.h"
 enum class SettlementType;
 enum class FacilityCategory;
 
@@ -17,9 +18,12 @@ public:
     BaseAction();
     ActionStatus getStatus() const;
     virtual void act(Simulation &simulation) = 0;
-    virtual const string toString() const = 0;
+    virtual ActionRecord getRecord() const = 0; // what the actions log keeps of this action
+    virtual const string toString() const;
     virtual BaseAction *clone() const = 0;
     virtual ~BaseAction() = default;
+    static void *operator new(std::size_t size);
+    static void operator delete(void *pointer, std::size_t size);
 
 protected:
     void complete();
@@ -37,7 +41,7 @@ class SimulateStep : public BaseAction
 public:
     SimulateStep(const int numOfSteps);
     void act(Simulation &simulation) override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
     SimulateStep *clone() const override;
 
 private:
@@ -49,7 +53,7 @@ class AddPlan : public BaseAction
 public:
     AddPlan(const string &settlementName, const string &selectionPolicy);
     void act(Simulation &simulation) override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
     AddPlan *clone() const override;
 
 private:
@@ -63,7 +67,7 @@ public:
     AddSettlement(const string &settlementName, SettlementType settlementType);
     void act(Simulation &simulation) override;
     AddSettlement *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
     void errorChange(); 
 
 private:
@@ -77,7 +81,7 @@ public:
     AddFacility(const string &facilityName, const FacilityCategory facilityCategory, const int price, const int lifeQualityScore, const int economyScore, const int environmentScore);
     void act(Simulation &simulation) override;
     AddFacility *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
     void errorFacilityCatagory();
 
 private:
@@ -95,7 +99,7 @@ public:
     PrintPlanStatus(int planId);
     void act(Simulation &simulation) override;
     PrintPlanStatus *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
 
 private:
     const int planId;
@@ -107,7 +111,7 @@ public:
     ChangePlanPolicy(const int planId, const string &newPolicy);
     void act(Simulation &simulation) override;
     ChangePlanPolicy *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
 
 private:
     const int planId;
@@ -117,12 +121,23 @@ private:
 class PrintActionsLog : public BaseAction
 {
 public:
-    PrintActionsLog();
+    PrintActionsLog(); // every entry
+    explicit PrintActionsLog(int count); // the last count entries
+    PrintActionsLog(int from, int count); // count entries starting at entry from
     void act(Simulation &simulation) override;
     PrintActionsLog *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
 
 private:
+    enum class Range
+    {
+        ALL,
+        TAIL,
+        FROM
+    };
+    const Range range;
+    const int from;
+    const int count;
 };
 
 class Close : public BaseAction
@@ -136,24 +151,88 @@ public:
 private:
 };
 
+class PrintMemoryStats : public BaseAction
+{
+public:
+    PrintMemoryStats();
+    void act(Simulation &simulation) override;
+    PrintMemoryStats *clone() const override;
+    ActionRecord getRecord() const override;
+
+private:
+};
+
 class BackupSimulation : public BaseAction
 {
 public:
-    BackupSimulation();
+    BackupSimulation(const string &snapshotName);
     void act(Simulation &simulation) override;
     BackupSimulation *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
 
 private:
+    const string snapshotName;
 };
 
 class RestoreSimulation : public BaseAction
 {
 public:
-    RestoreSimulation();
+    RestoreSimulation(const string &snapshotName);
     void act(Simulation &simulation) override;
     RestoreSimulation *clone() const override;
-    const string toString() const override;
+    ActionRecord getRecord() const override;
+
+private:
+    const string snapshotName;
+};
+
+class PrintSnapshots : public BaseAction
+{
+public:
+    PrintSnapshots();
+    void act(Simulation &simulation) override;
+    PrintSnapshots *clone() const override;
+    ActionRecord getRecord() const override;
+
+private:
+};
+
+class PrintStats : public BaseAction
+{
+public:
+    PrintStats(bool reset); // reset clears the counters instead of printing them
+    void act(Simulation &simulation) override;
+    PrintStats *clone() const override;
+    ActionRecord getRecord() const override;
+
+private:
+    const bool reset;
+};
+
+class TopPlans : public BaseAction
+{
+public:
+    TopPlans(const string &metric, int count);
+    void act(Simulation &simulation) override;
+    TopPlans *clone() const override;
+    ActionRecord getRecord() const override;
+
+private:
+    // The log keeps the metric, so text that names no metric is logged as "unknown"
+    static string getLoggedMetric(const string &metric);
+    const string metric;
+    const int count;
+};
+
+class QueryPlans : public BaseAction
+{
+public:
+    QueryPlans(const string &mode, const vector<string> &predicates); // mode: count, ids or stats
+    void act(Simulation &simulation) override;
+    QueryPlans *clone() const override;
+    ActionRecord getRecord() const override;
 
 private:
+    const string mode;
+    const vector<string> predicates;
 };
\ No newline at end of file
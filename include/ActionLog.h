@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <cstdint>
+using std::string;
+using std::vector;
+
+enum class ActionStatus;
+class MemoryUsage;
+
+// What kind of action a log entry records
+enum class ActionCode : std::uint8_t
+{
+    STEP,
+    ADD_PLAN,
+    ADD_SETTLEMENT,
+    ADD_FACILITY,
+    PRINT_PLAN_STATUS,
+    CHANGE_PLAN_POLICY,
+    PRINT_ACTIONS_LOG,
+    PRINT_MEMORY_STATS,
+    BACKUP,
+    RESTORE,
+    PRINT_SNAPSHOTS,
+    PRINT_STATS,
+    TOP_PLANS,
+    QUERY_PLANS,
+};
+
+// Everything an action's log line shows
+struct ActionRecord
+{
+    ActionCode code;
+    ActionStatus status;
+    string name; // settlement, facility or snapshot name, if the action has one
+    int number;  // steps or plan id, if the action has one
+};
+
+// Append-only log of executed actions. Entries are stored column by column
+// (code and status in one byte, an id into the chunk's own name table, one
+// integer) in chunks that are sealed once full and shared between copies, so
+// copying the log into a snapshot costs one pointer per chunk plus the open
+// chunk. With a limit set it keeps only the latest entries, freeing whole
+// chunks (names included) as it goes.
+// Entries are numbered from 0 for the first action ever logged.
+class ActionLog
+{
+public:
+    ActionLog();
+    ActionLog(const ActionLog &other);
+    ActionLog &operator=(const ActionLog &other);
+    ActionLog(ActionLog &&other) = default;
+    ActionLog &operator=(ActionLog &&other) = default;
+    void append(const ActionRecord &record);
+    void setLimit(std::size_t maxEntries); // 0 keeps everything
+    std::size_t getEnd() const;            // number of the next entry
+    std::size_t getBegin() const;          // number of the oldest entry still kept
+    // Prints entries [from, from + count) that are still kept, one per line
+    void print(std::ostream &out, std::size_t from, std::size_t count) const;
+    void countMemory(MemoryUsage &usage) const;
+    static string describe(const ActionRecord &record);
+
+private:
+    static const std::size_t CHUNK_SIZE = 4096;
+    struct Chunk
+    {
+        Chunk();
+        vector<std::uint8_t> codes; // ActionCode << 1 | ActionStatus
+        vector<std::uint32_t> nameIds;
+        vector<std::int32_t> numbers;
+        vector<string> names; // distinct names of the chunk's entries; id 0 is the empty name
+    };
+
+    static void appendDescription(string &out, ActionCode code, ActionStatus status, const string &name, int number);
+    void dropOldChunks();
+    std::uint32_t internTailName(const string &name);
+
+    vector<std::shared_ptr<const Chunk>> chunks; // full chunks, oldest first
+    Chunk tail;
+    std::size_t firstChunk; // number of the first entry in chunks[0]
+    std::size_t limit;
+    // Ids of tail.names; not copied with the log, rebuilt on the copy's first append
+    std::unordered_map<string, std::uint32_t> tailNameIds;
+};
@@ -7,5 +7,17 @@
 class Auxiliary
 {
 public:
+    // A word inside a larger buffer; it points into the buffer instead of owning a copy
+    struct Token
+    {
+        const char *data;
+        std::size_t length;
+        bool equals(const char *text) const;
+        std::string toString() const;
+    };
+
     static std::vector<std::string> parseArguments(const std::string &line);
+    static std::size_t splitArguments(const char *begin, const char *end, Token *tokens, std::size_t maxTokens);
+    static int parseInt(const Token &token);
+    static void appendInt(std::string &out, int value);
 };
@@ -0,0 +1,82 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "MemoryUsage.h"
+using std::vector;
+
+// A vector of heap objects shared copy-on-write between copies of the owner.
+// Copying a CowVector only shares the storage. Appending never copies while
+// this copy ends where the shared storage ends; writing to an element copies
+// the element list and that one element, and only if another copy still
+// sees them.
+template <typename T>
+class CowVector
+{
+public:
+    CowVector() : items(std::make_shared<vector<std::shared_ptr<T>>>()), length(0) {}
+
+    std::size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const T &operator[](std::size_t index) const { return *(*items)[index]; }
+
+    // Takes ownership of item
+    void push_back(T *item)
+    {
+        if (items->size() != length)
+        {
+            detach();
+        }
+        items->push_back(std::shared_ptr<T>(item));
+        length++;
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        if (items.use_count() == 1 && items->size() == length)
+        {
+            items->reserve(capacity);
+        }
+    }
+
+    // Make the element list private to this copy. Call before handing elements
+    // to several threads through getMutable().
+    void detach()
+    {
+        if (items.use_count() > 1)
+        {
+            items = std::make_shared<vector<std::shared_ptr<T>>>(items->begin(), items->begin() + length);
+        }
+        else
+        {
+            items->resize(length); // drop entries appended by a copy that no longer exists
+        }
+    }
+
+    T &getMutable(std::size_t index)
+    {
+        if (items.use_count() > 1 || items->size() != length)
+        {
+            detach();
+        }
+        std::shared_ptr<T> &item = (*items)[index];
+        if (item.use_count() > 1)
+        {
+            item = std::make_shared<T>(*item);
+        }
+        return *item;
+    }
+
+    // The element list, then each element this copy sees
+    void countMemory(MemoryUsage &usage) const
+    {
+        usage.visit(items.get(), sizeof(*items) + items->capacity() * sizeof(std::shared_ptr<T>));
+        for (std::size_t i = 0; i < length; i++)
+        {
+            (*items)[i]->countMemory(usage);
+        }
+    }
+
+private:
+    std::shared_ptr<vector<std::shared_ptr<T>>> items;
+    std::size_t length; // entries of *items visible to this copy
+};
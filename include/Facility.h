@@ -4,6 +4,8 @@
 using std::string;
 using std::vector;
 
+class Settlement;
+
 enum class FacilityStatus
 {
     UNDER_CONSTRUCTIONS,
@@ -39,12 +41,22 @@ protected:
     const int environment_score;
 };
 
-class Facility : public FacilityType
+// A built facility. It only holds a handle into the facility catalog and its
+// settlement; everything describing the facility type is read through them.
+class Facility
 {
 
 public:
-    Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score);
-    Facility(const FacilityType &type, const string &settlementName);
+    Facility(const vector<FacilityType> &catalog, int typeIndex, const Settlement &settlement);
+    Facility(const vector<FacilityType> &catalog, int typeIndex, const Settlement &settlement, FacilityStatus status, int timeLeft);
+    const FacilityType &getType() const;
+    int getTypeIndex() const;
+    const string &getName() const;
+    int getCost() const;
+    int getLifeQualityScore() const;
+    int getEnvironmentScore() const;
+    int getEconomyScore() const;
+    FacilityCategory getCategory() const;
     const string &getSettlementName() const;
     const int getTimeLeft() const;
     FacilityStatus step();
@@ -52,11 +64,12 @@ public:
     const FacilityStatus &getStatus() const;
     const string getStatusString() const; 
     const string toString() const;
-    Facility *clone() const override;
-    virtual ~Facility() = default;
+    Facility *clone() const;
 
 private:
-    const string settlementName;
+    const vector<FacilityType> *catalog;
+    int typeIndex;
+    const Settlement *settlement;
     FacilityStatus status;
     int timeLeft;
 };
\ No newline at end of file
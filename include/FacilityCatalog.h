@@ -0,0 +1,79 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Facility.h"
+#include "NameIndex.h"
+using std::string;
+using std::vector;
+
+class MemoryUsage;
+
+// The facility types a simulation can build, with a name index so lookups
+// don't scan the list. Copies share their storage the way CowVector does:
+// types are only ever appended, a copy that ends where the storage ends
+// appends in place, and a copy only sees the first size() types. Only a copy
+// that appends after another one appended past it (a restored snapshot that
+// grows) pays for storage of its own, so adding a facility after a backup
+// doesn't copy the catalog. Every distinct content gets its own version
+// number, which lets policies tell whether results they cached for a catalog
+// still hold. A per-category "next index" table lets the round-robin category
+// policies find their next facility without scanning past the other categories.
+class FacilityCatalog
+{
+public:
+    FacilityCatalog();
+    // May hold types appended by other copies past size(); index it with
+    // indices below size() only
+    const vector<FacilityType> &getTypes() const;
+    std::size_t size() const;
+    int find(const string &name) const; // index of the first type with this name, or -1
+    // First index at or after from with this category, wrapping to the start; -1 if none
+    int findNextInCategory(FacilityCategory category, int from) const;
+    void push_back(const FacilityType &facility);
+    void reserve(std::size_t capacity);
+    void countMemory(MemoryUsage &usage) const; // approximate
+    unsigned long long getVersion() const; // copies keep it, changes replace it
+
+private:
+    struct Storage
+    {
+        Storage();
+        vector<FacilityType> types;
+        // nextInCategory[c][i]: first index >= i with category c, or -1. An
+        // entry past a copy's size() means none for that copy.
+        vector<vector<int>> nextInCategory;
+        vector<int> lastInCategory;
+        void append(const FacilityType &facility);
+    };
+    std::shared_ptr<Storage> storage;
+    std::size_t length; // types visible to this copy
+    NameIndex indexByName;
+    unsigned long long version;
+    void detach();
+};
+
+// Called for every round-robin pick, so they are inline
+inline std::size_t FacilityCatalog::size() const
+{
+    return length;
+}
+
+inline int FacilityCatalog::findNextInCategory(FacilityCategory category, int from) const
+{
+    if (length == 0)
+    {
+        return -1;
+    }
+    const vector<int> &next = storage->nextInCategory[static_cast<int>(category)];
+    if (from >= 0 && static_cast<std::size_t>(from) < length)
+    {
+        int found = next[from];
+        if (found != -1 && static_cast<std::size_t>(found) < length)
+        {
+            return found;
+        }
+    }
+    int first = next[0];
+    return first != -1 && static_cast<std::size_t>(first) < length ? first : -1;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <vector>
+using std::vector;
+
+class MemoryUsage;
+
+// Append-only list of a plan's operational facilities (catalog indices).
+// Entries are grouped into fixed-size chunks that never change once full,
+// and copies share those chunks, so a copied plan costs one pointer per
+// chunk plus the partly filled tail. Plans saved in different snapshots
+// therefore share all the history they have in common.
+class FacilityHistory
+{
+public:
+    FacilityHistory();
+    std::size_t size() const;
+    int operator[](std::size_t index) const;
+    void push_back(int typeIndex);
+    void countMemory(MemoryUsage &usage) const; // the tail here, each chunk on its own
+
+private:
+    static const std::size_t CHUNK_SIZE = 256;
+    vector<std::shared_ptr<const vector<int>>> chunks; // full chunks
+    vector<int> tail;
+};
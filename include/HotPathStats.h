@@ -0,0 +1,141 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "ActionLog.h"
+using std::vector;
+
+// Always-on counters for the engine's hot paths: call counts, total and
+// longest wall time per probe and per action type, plus facility churn.
+// Per-plan probes run millions of times a step, so SampledTimer counts every
+// call but reads the clock for one call in SAMPLE_PERIOD; their total time is
+// extrapolated from the timed calls, and their longest time is the longest
+// timed call (printed as SampledMaxNs).
+// Each thread counts into its own block, so the step workers never contend
+// on shared cache lines. print() and reset() go over every block and must
+// only be called while no plans are being stepped (between commands).
+class HotPathStats
+{
+    struct Counter;
+
+public:
+    enum class Probe
+    {
+        SIMULATION_STEP,
+        PLAN_STEP,
+        SELECT_FACILITY,
+        BACKUP,
+        RESTORE,
+    };
+
+    // Times its own lifetime into a probe
+    class Timer
+    {
+    public:
+        explicit Timer(Probe probe);
+        ~Timer();
+        Timer(const Timer &other) = delete;
+        Timer &operator=(const Timer &other) = delete;
+
+    private:
+        Probe probe;
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    class SampledTimer
+    {
+    public:
+        explicit SampledTimer(Probe probe);
+        ~SampledTimer();
+        SampledTimer(const SampledTimer &other) = delete;
+        SampledTimer &operator=(const SampledTimer &other) = delete;
+
+    private:
+        Counter *counter; // nullptr when this call is not timed
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    static void record(Probe probe, std::uint64_t nanoseconds);
+    static void recordAction(ActionCode code, std::uint64_t nanoseconds);
+    static void addFacilities(std::uint64_t created, std::uint64_t completed);
+    static void addSimulatedSteps(std::uint64_t steps);
+    static void print(std::ostream &out);
+    static void reset();
+
+private:
+    static const int PROBE_COUNT = static_cast<int>(Probe::RESTORE) + 1;
+    static const int ACTION_COUNT = static_cast<int>(ActionCode::QUERY_PLANS) + 1;
+    static const std::uint64_t SAMPLE_PERIOD = 64;
+
+    struct Counter
+    {
+        std::uint64_t calls;
+        std::uint64_t timedCalls;
+        std::uint64_t timedNanoseconds;
+        std::uint64_t maxNanoseconds;
+        void add(std::uint64_t nanoseconds); // a timed call
+        void addTimed(std::uint64_t nanoseconds); // time of a call already counted
+        void merge(const Counter &other);
+    };
+
+    struct Block
+    {
+        Counter probes[PROBE_COUNT];
+        Counter actions[ACTION_COUNT];
+        std::uint64_t facilitiesCreated;
+        std::uint64_t facilitiesCompleted;
+        std::uint64_t simulatedSteps;
+    };
+
+    HotPathStats();
+    HotPathStats(const HotPathStats &other) = delete;
+    HotPathStats &operator=(const HotPathStats &other) = delete;
+    static HotPathStats &instance();
+    static void printCounter(std::ostream &out, const char *kind, const char *name, const Counter &counter);
+    static Block &local(); // the calling thread's block
+    static Block &createLocal();
+    static thread_local Block *localBlock;
+
+    vector<std::unique_ptr<Block>> blocks; // one per thread that ever counted
+    std::mutex mutex;                     // guards blocks, not their contents
+};
+
+inline HotPathStats::Timer::Timer(Probe probe) : probe(probe), begin(std::chrono::steady_clock::now()) {}
+
+inline HotPathStats::Timer::~Timer()
+{
+    record(probe, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+}
+
+inline HotPathStats::Block &HotPathStats::local()
+{
+    return localBlock != nullptr ? *localBlock : createLocal();
+}
+
+inline void HotPathStats::addFacilities(std::uint64_t created, std::uint64_t completed)
+{
+    Block &block = local();
+    block.facilitiesCreated += created;
+    block.facilitiesCompleted += completed;
+}
+
+inline HotPathStats::SampledTimer::SampledTimer(Probe probe) : counter(nullptr), begin()
+{
+    Counter &probeCounter = local().probes[static_cast<int>(probe)];
+    if (probeCounter.calls++ % SAMPLE_PERIOD == 0)
+    {
+        counter = &probeCounter;
+        begin = std::chrono::steady_clock::now();
+    }
+}
+
+inline HotPathStats::SampledTimer::~SampledTimer()
+{
+    if (counter != nullptr)
+    {
+        counter->addTimed(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Plan.h"
+#include "CowVector.h"
+using std::string;
+using std::vector;
+
+// Plans ranked by each score metric, for top-k queries that don't scan every
+// plan. Each metric keeps a tournament tree over the plan ids: every node
+// holds the best plan below it, so changing a plan's score updates one path
+// and a top-k query visits O(k log n) nodes. Stepping only reports which
+// plans' scores changed; the trees take those changes in when they are next
+// queried, so a plan that changed over several steps is moved once. The trees
+// are built on the first query and are not copied with the simulation
+// (backups stay cheap), so after a restore they are built again on demand.
+class Leaderboard
+{
+public:
+    enum class Metric
+    {
+        LIFE_QUALITY,
+        ECONOMY,
+        ENVIRONMENT,
+        TOTAL,
+        BALANCE, // spread between the highest and lowest score; smaller ranks higher
+    };
+
+    Leaderboard();
+    static bool parseMetric(const string &name, Metric &metric);
+    static long long getScore(const Plan &plan, Metric metric);
+    bool isBuilt() const;
+    void clear(); // forget the rankings until the next query
+    void markChanged(const vector<int> &planIds); // plans whose scores may have changed
+    void markAdded(int planId);
+    // Ids of the best count plans by metric, best first; ties go to the lower id
+    void getTop(const CowVector<Plan> &plans, Metric metric, std::size_t count, vector<int> &planIds);
+
+private:
+    static const int METRIC_COUNT = static_cast<int>(Metric::BALANCE) + 1;
+
+    struct Ranking
+    {
+        Ranking();
+        vector<long long> keys; // by plan id; the best plan has the smallest key
+        vector<int> best;       // best[node] is the best plan id under node, -1 if none; leaves start at leafCount
+        std::size_t leafCount;
+        int better(int first, int second) const;
+        void update(int planId, long long key);
+        void rebuild();
+    };
+
+    static long long getKey(long long score, Metric metric);
+    void build(const CowVector<Plan> &plans);
+    void applyChanges(const CowVector<Plan> &plans);
+
+    bool built;
+    Ranking rankings[METRIC_COUNT];
+    vector<int> changedPlans;
+    vector<char> isChanged; // by plan id, so changedPlans has no duplicates
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+using std::string;
+
+// Read-only view of a whole file. The file is memory-mapped where possible,
+// so large configs are parsed in place without being copied; if mapping
+// fails it is read into memory instead.
+class MappedFile
+{
+public:
+    MappedFile(const string &path);
+    ~MappedFile();
+    bool isOpen() const;
+    const char *getData() const;
+    std::size_t getSize() const;
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+private:
+    const char *data;
+    std::size_t size;
+    bool opened;
+    bool mapped; // data must be unmapped rather than being part of contents
+    string contents;
+};
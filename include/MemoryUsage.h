@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+
+// Memory held by a group of copy-on-write copies (the snapshots), with every
+// heap object counted once however many copies of the group share it. A copy
+// reports its objects through countMemory(), one visit per object. Objects
+// that a copy outside the group (the live run) also holds can be set aside
+// while it does, since dropping the group would not free them.
+class MemoryUsage
+{
+public:
+    enum class Mode
+    {
+        ADD,     // a copy joins the group
+        REMOVE,  // a copy leaves the group
+        EXCLUDE, // a copy outside the group: its objects stop counting
+        INCLUDE, // undoes EXCLUDE for the same copy
+        MEASURE, // a copy in the group: sums the objects no other copy holds
+    };
+
+    MemoryUsage();
+    void setMode(Mode mode);
+    void visit(const void *object, std::size_t bytes);
+    std::size_t getBytes() const;         // the group's objects, excluded ones left out
+    std::size_t getMeasuredBytes() const; // since the last setMode(MEASURE)
+
+private:
+    struct Entry
+    {
+        std::size_t bytes; // as reported when the first holder was added
+        unsigned holders;
+        bool excluded;
+    };
+    std::unordered_map<const void *, Entry> entries;
+    Mode mode;
+    std::size_t bytes;
+    std::size_t measuredBytes;
+};
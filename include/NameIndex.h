@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+using std::string;
+
+class MemoryUsage;
+
+// Name -> position index for an append-only list (settlements, facility
+// types) whose copies share storage, as in CowVector. Copies share one map and
+// append to it in place as long as they end where the map ends; a name is
+// visible to a copy only if its position is below the copy's size. Only a copy
+// that appends after another copy appended past it (a restored snapshot that
+// grows) pays for its own map.
+class NameIndex
+{
+public:
+    NameIndex();
+    std::size_t size() const;
+    int find(const string &name) const; // position of the first entry with this name, or -1
+    void push_back(const string &name); // a repeated name keeps its first position
+    void reserve(std::size_t capacity);
+    void countMemory(MemoryUsage &usage) const; // approximate
+
+private:
+    struct Names
+    {
+        Names();
+        std::unordered_map<string, int> positions;
+        std::size_t length; // entries appended, including repeated names
+    };
+    std::shared_ptr<Names> names;
+    std::size_t length; // entries visible to this copy
+    void detach();
+};
+
+inline std::size_t NameIndex::size() const
+{
+    return length;
+}
+
+inline int NameIndex::find(const string &name) const
+{
+    std::unordered_map<string, int>::const_iterator it = names->positions.find(name);
+    if (it == names->positions.end() || static_cast<std::size_t>(it->second) >= length)
+    {
+        return -1;
+    }
+    return it->second;
+}
@@ -3,8 +3,12 @@
 #include "Facility.h"
 #include "Settlement.h"
 #include "SelectionPolicy.h"
+#include "FacilityHistory.h"
+#include "FacilityCatalog.h"
 using std::vector;
 
+class MemoryUsage;
+
 enum class PlanStatus
 {
     AVALIABLE,
@@ -14,29 +18,41 @@ enum class PlanStatus
 class Plan
 {
 public:
-    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
-    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions, int life_quality_score, int economy_score, int environment_score, vector<Facility *> facilities, vector<Facility *> underConstruction);
+    Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy);
 
     const int getlifeQualityScore() const;
     const int getEconomyScore() const;
     const int getEnvironmentScore() const;
     void setSelectionPolicy(SelectionPolicy *selectionPolicy);
-    void step();
+    // The facility catalog is passed in rather than stored, so that a plan can be
+    // shared between a simulation and its backups even after their catalogs differ
+    void step(const FacilityCatalog &catalog);
+    void advance(int numOfSteps, const FacilityCatalog &catalog);
+    int getStepsToNextEvent() const;
     void printStatus();
 
-    const vector<Facility *> &getFacilities() const; // Corrected
-    const std::vector<Facility *> &getUnderConstruction() const;
+    int getFacilityCount() const;
+    Facility getFacility(int index, const vector<FacilityType> &facilityOptions) const; // operational facilities first, then those under construction
+    int getUnderConstructionCount() const;
 
-    void addFacility(Facility *facility);
-    const string toString() const;
+    // A restored plan picks up as available, as plan copies always did. Restores
+    // are numbered, and a busy plan reads as available until it is resumed for
+    // the latest restore of its simulation, which happens before its next
+    // change. Restoring therefore doesn't touch (or copy) any plan.
+    PlanStatus getStatus(unsigned long long latestRestore) const;
+    void resume(unsigned long long latestRestore);
+    void countMemory(MemoryUsage &usage) const;
+    const string toString(const vector<FacilityType> &facilityOptions) const;
+    void appendStatus(string &out, const vector<FacilityType> &facilityOptions, unsigned long long latestRestore) const;
 
     Plan(const Plan &other);
     ~Plan();
-    Plan(Plan &&other);
+    Plan(Plan &&other) noexcept;
     Plan &operator=(const Plan &other) = delete;
     Plan &operator=(Plan &&other) = delete;
 
     const string &getSettlement() const;
+    SettlementType getSettlementType() const;
     int getPlanId() const;
     SelectionPolicy *getSelectionPolicy() const;
 
@@ -45,8 +61,13 @@ private:
     const Settlement &settlement;
     SelectionPolicy *selectionPolicy;
     PlanStatus status;
-    vector<Facility *> facilities;
-    vector<Facility *> underConstruction;
-    const vector<FacilityType> &facilityOptions;
+    unsigned long long resumedRestore; // latest restore this plan was resumed for
+    FacilityHistory facilities; // operational facilities, as indices into facilityOptions
+    // Facilities under construction, stored as parallel arrays (one slot per facility)
+    vector<int> constructionTypes; // index into facilityOptions
+    vector<int> constructionTimeLeft;
+    vector<FacilityStatus> constructionStatus;
     int life_quality_score, economy_score, environment_score;
+    void skipSteps(int numOfSteps);
+    vector<int> getCycleKey() const;
 };
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Plan.h"
+#include "CowVector.h"
+using std::string;
+using std::vector;
+
+// Which plans a query selects. Categorical fields are -1 (or an empty
+// settlement name) when the query doesn't restrict them; score ranges are
+// inclusive.
+struct PlanFilter
+{
+    PlanFilter();
+    string settlementName;
+    int settlementType; // SettlementType
+    int policy;         // PolicyKind
+    int status;         // PlanStatus
+    long long minScore[4]; // life quality, economy, environment, total
+    long long maxScore[4];
+    bool contradictory; // no plan can match, e.g. two values asked for one field
+    // Adds one "<field><op><value>" predicate, e.g. status=busy or economy>500
+    bool addPredicate(const string &predicate, string &errorMsg);
+};
+
+// Secondary indexes over the plans for queries: plan ids by settlement name,
+// settlement type, selection policy and status. Settlements never change, so
+// those lists only grow; policy and status lists are moved between in O(1) as
+// plans change. Stepping and policy changes only report the plans they
+// touched, and the index takes those in at the next query. Like the
+// leaderboard, the index is built on the first query and is not copied with
+// the simulation, so a restore makes the next query rebuild it.
+class PlanIndex
+{
+public:
+    PlanIndex();
+    bool isBuilt() const;
+    void clear();
+    void markChanged(const vector<int> &planIds); // plans whose policy or status may have changed
+    // Ids of the plans that match filter, in ascending order
+    void select(const CowVector<Plan> &plans, const PlanFilter &filter, unsigned long long latestRestore, vector<int> &planIds);
+
+private:
+    // Plan ids grouped by the current value of one attribute
+    struct Partition
+    {
+        Partition(int valueCount);
+        vector<vector<int>> members;
+        vector<int> valueOf;  // by plan id
+        vector<int> position; // by plan id: index in members[valueOf[id]]
+        void add(int planId, int value);
+        void move(int planId, int value);
+    };
+
+    void refresh(const CowVector<Plan> &plans, unsigned long long latestRestore);
+    bool matches(const Plan &plan, int planId, const PlanFilter &filter) const;
+
+    bool built;
+    std::size_t indexedPlans;
+    std::unordered_map<string, vector<int>> bySettlement;
+    Partition bySettlementType;
+    Partition byPolicy;
+    Partition byStatus;
+    vector<int> changedPlans;
+    vector<char> isChanged; // by plan id, so changedPlans has no duplicates
+};
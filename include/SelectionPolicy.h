@@ -1,52 +1,90 @@
 #pragma once
 #include <vector>
+#include <stdexcept>
 #include "Facility.h"
+#include "FacilityCatalog.h"
+#include <unordered_map>
 using std::vector;
 
+// The closed set of policies, so hot loops can switch to the concrete class
+enum class PolicyKind
+{
+    NAIVE,
+    BALANCED,
+    ECONOMY,
+    SUSTAINABILITY,
+};
+
 class SelectionPolicy
 {
 public:
-    virtual const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) = 0;
+    explicit SelectionPolicy(PolicyKind kind);
+    PolicyKind getKind() const;
+    virtual const FacilityType &selectFacility(const FacilityCatalog &catalog) = 0;
+    // Makes count selections in one call, appending their catalog indices to selected
+    virtual void selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected) = 0;
     virtual const string toString() const = 0;
+    virtual int getCursor() const = 0; // round-robin position, or -1 if the policy has no cursor
     virtual SelectionPolicy *clone() const = 0;
     virtual ~SelectionPolicy() = default;
+    static void *operator new(std::size_t size);
+    static void operator delete(void *pointer, std::size_t size);
+
+private:
+    PolicyKind kind;
 };
 
-class NaiveSelection : public SelectionPolicy
+class NaiveSelection final : public SelectionPolicy
 {
 public:
     NaiveSelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    const FacilityType &selectFacility(const FacilityCatalog &catalog) override;
+    void selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected) override;
+    int selectIndex(const FacilityCatalog &catalog); // next pick, as a catalog index
     const string toString() const override;
     NaiveSelection *clone() const override;
+    int getCursor() const override;
     ~NaiveSelection() override = default;
 
 private:
     int lastSelectedIndex;
 };
 
-class BalancedSelection : public SelectionPolicy
+class BalancedSelection final : public SelectionPolicy
 {
 public:
     BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    BalancedSelection(const BalancedSelection &other);
+    BalancedSelection &operator=(const BalancedSelection &other) = delete;
+    const FacilityType &selectFacility(const FacilityCatalog &catalog) override;
+    void selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected) override;
+    int selectIndex(const FacilityCatalog &catalog);
     const string toString() const override;
     BalancedSelection *clone() const override;
+    int getCursor() const override;
     ~BalancedSelection() override = default;
 
 private:
     int LifeQualityScore;
     int EconomyScore;
     int EnvironmentScore;
+    // The choice only depends on the score offsets (Life-Env, Eco-Env), so it
+    // is remembered per offset pair for the catalog version it was made with
+    std::unordered_map<unsigned long long, int> decisionCache;
+    unsigned long long cacheVersion;
+    int chooseFacility(const FacilityCatalog &catalog) const;
 };
 
-class EconomySelection : public SelectionPolicy
+class EconomySelection final : public SelectionPolicy
 {
 public:
     EconomySelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    const FacilityType &selectFacility(const FacilityCatalog &catalog) override;
+    void selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected) override;
+    int selectIndex(const FacilityCatalog &catalog);
     const string toString() const override;
     EconomySelection *clone() const override;
+    int getCursor() const override;
 
     ~EconomySelection() override = default;
 
@@ -54,15 +92,98 @@ private:
     int lastSelectedIndex;
 };
 
-class SustainabilitySelection : public SelectionPolicy
+class SustainabilitySelection final : public SelectionPolicy
 {
 public:
     SustainabilitySelection();
-    const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override;
+    const FacilityType &selectFacility(const FacilityCatalog &catalog) override;
+    void selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected) override;
+    int selectIndex(const FacilityCatalog &catalog);
     const string toString() const override;
     SustainabilitySelection *clone() const override;
+    int getCursor() const override;
     ~SustainabilitySelection() override = default;
 
 private:
     int lastSelectedIndex;
-};
\ No newline at end of file
+};
+
+inline PolicyKind SelectionPolicy::getKind() const
+{
+    return kind;
+}
+
+// The round-robin picks are a few instructions each; they are defined here so
+// that fillSelections can inline them into the caller's loop
+
+inline int NaiveSelection::selectIndex(const FacilityCatalog &catalog)
+{
+    lastSelectedIndex = (lastSelectedIndex + 1) % catalog.size(); // so it will return to the start of the vector (we dont want unexpected behavior)
+    return lastSelectedIndex;
+}
+
+inline int EconomySelection::selectIndex(const FacilityCatalog &catalog)
+{
+    if (catalog.size() == 0)
+    {
+        throw std::runtime_error("No facilities available to select from.");
+    }
+
+    // First matching facility from lastSelectedIndex on, else the first one from the start
+    int i = catalog.findNextInCategory(FacilityCategory::ECONOMY, lastSelectedIndex);
+    if (i == -1)
+    {
+        throw std::runtime_error("No facility with the correct category found.");
+    }
+    lastSelectedIndex = (i + 1) % catalog.size(); // Update to the next index
+    return i;
+}
+
+inline int SustainabilitySelection::selectIndex(const FacilityCatalog &catalog)
+{
+    if (catalog.size() == 0)
+    {
+        throw std::runtime_error("No facilities available to select from.");
+    }
+
+    // First matching facility from lastSelectedIndex on, else the first one from the start
+    int i = catalog.findNextInCategory(FacilityCategory::ENVIRONMENT, lastSelectedIndex);
+    if (i == -1)
+    {
+        throw std::runtime_error("No facility with the correct category found.");
+    }
+    lastSelectedIndex = (i + 1) % catalog.size(); // Update to the next index
+    return i;
+}
+
+// count picks of a policy whose class is known at compile time: no virtual
+// call per pick
+template <typename Policy>
+inline void fillSelections(Policy &policy, const FacilityCatalog &catalog, int count, vector<int> &selected)
+{
+    for (int i = 0; i < count; i++)
+    {
+        selected.push_back(policy.selectIndex(catalog));
+    }
+}
+
+// Same as policy.selectFacilities, but switches on the policy kind so each
+// case is a specialized, inlinable loop instead of an indirect call
+inline void fillSelectionsByKind(SelectionPolicy &policy, const FacilityCatalog &catalog, int count, vector<int> &selected)
+{
+    switch (policy.getKind())
+    {
+    case PolicyKind::NAIVE:
+        fillSelections(static_cast<NaiveSelection &>(policy), catalog, count, selected);
+        break;
+    case PolicyKind::BALANCED:
+        fillSelections(static_cast<BalancedSelection &>(policy), catalog, count, selected);
+        break;
+    case PolicyKind::ECONOMY:
+        fillSelections(static_cast<EconomySelection &>(policy), catalog, count, selected);
+        break;
+    case PolicyKind::SUSTAINABILITY:
+        fillSelections(static_cast<SustainabilitySelection &>(policy), catalog, count, selected);
+        break;
+    }
+}
@@ -5,6 +5,7 @@ using std::string;
 using std::vector;
 
 class Facility;
+class MemoryUsage;
 
 enum class SettlementType
 {
@@ -20,6 +21,7 @@ public:
     const string &getName() const;
     SettlementType getType() const;
     const string toString() const;
+    void countMemory(MemoryUsage &usage) const;
 
 private:
     const string name;
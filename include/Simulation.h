@@ -5,27 +5,44 @@
 #include "Plan.h"
 #include "Settlement.h"
 #include "globals.h"
+#include "WorkerPool.h"
+#include "CowVector.h"
+#include "FacilityCatalog.h"
+#include "ActionLog.h"
+#include "Leaderboard.h"
+#include "PlanIndex.h"
+#include "NameIndex.h"
+#include <memory>
+#include <istream>
+#include <unordered_map>
 
 using std::string;
 using std::vector;
 
 class BaseAction;
 class SelectionPolicy;
+class MemoryUsage;
 
 class Simulation
 {
 public:
-    Simulation(const string &configFilePath); 
+    Simulation(const string &configFilePath, WorkerPool *workerPool = nullptr); // the pool, if any, also parses the config
     void start();
+    void runBatch(std::istream &commands, bool quiet);
     void addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
-    void addAction(BaseAction *action);
+    void addAction(BaseAction *action); // logs the action and deletes it
     bool addSettlement(Settlement *settlement);
-    bool addFacility(FacilityType facility);
+    bool addFacility(const FacilityType &facility);
     bool isSettlementExists(const string &settlementName);
-    bool isPlanIdExsits(const int planID);
-    Settlement &getSettlement(const string &settlementName);
-    Plan &getPlan(const int planID);
+    bool isPlanIdExsits(const int planID) const;
+    const Settlement &getSettlement(const string &settlementName);
+    const Plan &getPlan(const int planID) const;
+    Plan &getPlanForUpdate(const int planID);
+    unsigned long long getLatestRestore() const; // see Plan::getStatus
+    const vector<FacilityType> &getFacilitiesOptions() const; // see FacilityCatalog::getTypes
     void step();
+    void step(int numOfSteps);
+    void setWorkerPool(WorkerPool *pool);
     void close();
     void open();
     void parseConfigFile(const std::string &configFilePath);
@@ -34,8 +51,16 @@ public:
     std::vector<std::string> parseToWords(const std::string& input);
     void actionHandler(const std::string &action);
     void printLog() const;
-    void backup();
-    bool restore();
+    void printLog(std::size_t from, std::size_t count) const;
+    std::size_t getLogEnd() const; // number of the next log entry
+    void setLogLimit(std::size_t maxEntries); // keep only the latest entries; 0 keeps all
+    void backup(const string &snapshotName);
+    bool restore(const string &snapshotName);
+    void printSnapshots() const;
+    int getPlanCount() const;
+    void getTopPlans(Leaderboard::Metric metric, std::size_t count, vector<int> &planIds); // best first
+    void queryPlans(const PlanFilter &filter, vector<int> &planIds); // ascending ids
+    void countMemory(MemoryUsage &usage) const; // every object this copy holds, shared or not
     //rule of 5
     Simulation(const Simulation &other);
     Simulation &operator=(const Simulation &other);
@@ -45,12 +70,20 @@ public:
 private:
     bool isRunning;
     int planCounter; // For assigning unique plan IDs
-    vector<BaseAction *> actionsLog;
-    vector<Plan> plans;
-    vector<Settlement *> settlements;
-    vector<FacilityType> facilitiesOptions;
+    unsigned long long latestRestore; // number of the restore this state came from, 0 if none
+    // The state below is shared copy-on-write with backups, so copying a
+    // Simulation is cheap and later changes only duplicate what they touch
+    ActionLog actionsLog;
+    CowVector<Plan> plans;
+    CowVector<Settlement> settlements;
+    NameIndex settlementIndex; // name -> index in settlements
+    std::shared_ptr<FacilityCatalog> facilityCatalog;
+    WorkerPool *workerPool; // not owned; nullptr steps plans on the calling thread
+    Leaderboard leaderboard; // never copied; a copy builds its own when queried
+    PlanIndex planIndex; // likewise
+    void markPlansChanged(const vector<int> &planIds);
+    Plan &getMutablePlan(std::size_t index);
     void parseConfig(const std::string &configFilePath);
-    void handleSettlementCommand(const std::vector<std::string> &arguments);
-    void handleFacilityCommand(const std::vector<std::string> &arguments);
-    void handlePlanCommand(const std::vector<std::string> &arguments);
+    FacilityCatalog &getFacilityCatalogForUpdate();
+    const Settlement *findSettlement(const string &settlementName) const;
 };
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <mutex>
+using std::vector;
+
+// Size-class pool behind the class-level operator new/delete of the small,
+// frequently cloned polymorphic objects (selection policies and actions).
+// Blocks come from 64 KiB slabs and go back to a per-size free list when the
+// object is deleted, so clone-heavy paths such as backup and restore recycle
+// memory instead of calling malloc/free for every object.
+// Each thread keeps its own free lists, so the step workers, which copy plans
+// shared with a backup (policy included), never contend; the mutex is only
+// taken to carve a new slab. A block joins the lists of the thread that frees
+// it. releaseFreeSlabs() gives slabs whose blocks are all free back to the
+// system. Like HotPathStats::print, it goes over every thread's lists and must
+// only be called while no plans are being stepped (between commands).
+class SlabAllocator
+{
+public:
+    static void *allocate(std::size_t size);
+    static void deallocate(void *pointer, std::size_t size);
+    // Only does the work once enough has been freed since the last release
+    static void releaseFreeSlabs();
+    static void printStats(std::ostream &out);
+
+private:
+    static const std::size_t GRANULARITY = 16;
+    static const std::size_t MAX_BLOCK_SIZE = 256;
+    static const std::size_t SIZE_CLASS_COUNT = MAX_BLOCK_SIZE / GRANULARITY;
+    static const std::size_t SLAB_SIZE = 64 * 1024;
+
+    struct SizeClass
+    {
+        void *freeList;
+        std::size_t freeBlocks;
+        std::size_t allocations;
+        std::size_t frees;
+    };
+
+    // One thread's free lists; sizeClasses[i] serves blocks of (i + 1) * GRANULARITY bytes
+    struct Cache
+    {
+        SizeClass sizeClasses[SIZE_CLASS_COUNT];
+        std::size_t largeAllocations; // too big for a size class, passed to ::operator new
+        std::size_t largeFrees;
+    };
+
+    SlabAllocator();
+    ~SlabAllocator();
+    SlabAllocator(const SlabAllocator &other) = delete;
+    SlabAllocator &operator=(const SlabAllocator &other) = delete;
+    static SlabAllocator &instance();
+    static Cache &local(); // the calling thread's cache
+    static Cache &createLocal();
+    static thread_local Cache *localCache;
+    void refill(SizeClass &sizeClass, std::size_t index);
+    std::size_t releaseSlabs(std::size_t index); // returns the free bytes left
+
+    vector<std::unique_ptr<Cache>> caches; // one per thread that ever allocated or freed
+    vector<vector<char *>> slabs;          // by size class
+    std::size_t freeBytesAfterRelease;
+    std::mutex mutex; // guards caches and slabs, not the caches' contents
+};
+
+inline SlabAllocator::Cache &SlabAllocator::local()
+{
+    return localCache != nullptr ? *localCache : createLocal();
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include "MemoryUsage.h"
+using std::string;
+using std::vector;
+
+class Simulation;
+
+// Named backups of the running simulation. Each snapshot is a copy-on-write
+// Simulation, so a snapshot only holds what changed since the state it shares
+// with the live run and the other snapshots: changed plans, new facility
+// history chunks and catalog entries. With a memory budget set, the store
+// keeps a running count of the memory its snapshots hold together, each
+// shared object once, and evicts the least recently used snapshots while
+// that count, less what the live run still holds, exceeds the budget.
+class SnapshotStore
+{
+public:
+    SnapshotStore(std::size_t memoryBudget); // in bytes, 0 for no limit
+    ~SnapshotStore();
+    void save(const string &name, const Simulation &simulation);
+    bool load(const string &name, Simulation &simulation);
+    void print(std::ostream &out, const Simulation &live) const;
+
+    SnapshotStore(const SnapshotStore &other) = delete;
+    SnapshotStore &operator=(const SnapshotStore &other) = delete;
+
+private:
+    struct Snapshot
+    {
+        string name;
+        Simulation *simulation;
+        unsigned long lastUsed;
+    };
+
+    void enforceBudget(const string &keep, const Simulation &live);
+
+    vector<Snapshot> snapshots;
+    std::size_t memoryBudget;
+    unsigned long useCounter;
+    MemoryUsage usage; // every snapshot added, kept only with a budget set
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+using std::vector;
+
+// A fixed set of worker threads that stay alive for the whole run and share
+// parallel loops with the calling thread.
+class WorkerPool
+{
+public:
+    WorkerPool(int numOfThreads);
+    ~WorkerPool();
+    int getThreadCount() const;
+    // Calls task(begin, end) over [0, count) in chunks of chunkSize. Idle threads
+    // grab the next free chunk, so uneven chunks balance out. Blocks until every
+    // chunk is done and rethrows the first exception a task threw.
+    void parallelFor(int count, int chunkSize, const std::function<void(int, int)> &task);
+
+    WorkerPool(const WorkerPool &other) = delete;
+    WorkerPool &operator=(const WorkerPool &other) = delete;
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    const std::function<void(int, int)> *task;
+    int count;
+    int chunkSize;
+    std::atomic<int> nextIndex;
+    int activeWorkers;
+    unsigned long round; // bumped for every parallelFor call
+    bool stopping;
+    std::exception_ptr failure;
+};
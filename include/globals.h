@@ -1,6 +1,6 @@
 // globals.h
 #pragma once
 
-class Simulation; // Forward declaration of Simulation
+class SnapshotStore; // Forward declaration of SnapshotStore
 
-extern Simulation *backupSim; // Declaration of the global variable
+extern SnapshotStore *snapshotStore; // Named backups, created on first use
@@ -1,7 +1,9 @@
 #include "Action.h"
 #include "Simulation.h"
+#include "SlabAllocator.h"
+#include "HotPathStats.h"
 #include <iostream>
-#include <sstream>
+#include <algorithm>
 using namespace std;
 
 // Constructor and generic methods
@@ -15,7 +17,7 @@ void BaseAction::error(string errorMsg)
 {
     this->errorMsg = std::move(errorMsg);
     status = ActionStatus::ERROR;
-    std::cout << "Error: " << this->errorMsg << std::endl;
+    std::cout << "Error: " << this->errorMsg << '\n';
 }
 
 ActionStatus BaseAction::getStatus() const
@@ -28,6 +30,21 @@ const string &BaseAction::getErrorMsg() const
     return errorMsg;
 }
 
+const string BaseAction::toString() const
+{
+    return ActionLog::describe(getRecord());
+}
+
+// Every command allocates an action and frees it once logged, so they come from the slab pool
+void *BaseAction::operator new(std::size_t size)
+{
+    return SlabAllocator::allocate(size);
+}
+void BaseAction::operator delete(void *pointer, std::size_t size)
+{
+    SlabAllocator::deallocate(pointer, size);
+}
+
 //--------------------------//////
 
 // SimulateStep Implementation
@@ -36,10 +53,7 @@ SimulateStep::SimulateStep(const int numOfSteps) : BaseAction(), numOfSteps(numO
 void SimulateStep::act(Simulation &simulation)
 {
     if (numOfSteps>0){
-    for (int i = 1; i <= numOfSteps; i++)
-    {
-        simulation.step();
-    }
+    simulation.step(numOfSteps);
     complete();
     }
     else {
@@ -47,12 +61,9 @@ void SimulateStep::act(Simulation &simulation)
     }
 }
 
-const string SimulateStep::toString() const
+ActionRecord SimulateStep::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: Step " + to_string(numOfSteps) + " ERROR");
-    else
-        return ("Action: Step " + to_string(numOfSteps) + " COMPLETED");
+    return ActionRecord{ActionCode::STEP, getStatus(), "", numOfSteps};
 }
 
 SimulateStep *SimulateStep::clone() const
@@ -68,8 +79,12 @@ PrintPlanStatus::PrintPlanStatus(int planId)
 void PrintPlanStatus::act(Simulation &simulation)
 {
     if (simulation.isPlanIdExsits(planId)){
-    Plan this_plan = simulation.getPlan(planId);
-    std::cout << this_plan.toString() << std::endl;
+    // Rendered straight from the live plan into a buffer reused across calls
+    static std::string status;
+    status.clear();
+    simulation.getPlan(planId).appendStatus(status, simulation.getFacilitiesOptions(), simulation.getLatestRestore());
+    status += '\n';
+    std::cout.write(status.data(), status.size());
     complete();
     }
     else {
@@ -80,12 +95,9 @@ PrintPlanStatus *PrintPlanStatus::clone() const
 {
     return new PrintPlanStatus(*this);
 }
-const string PrintPlanStatus::toString() const
+ActionRecord PrintPlanStatus::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: PrintPlanStatus of Plan" + to_string(planId) + " ERROR");
-    else
-        return ("Action: PrintPlanStatus of Plan" + to_string(planId) + +" COMPLETED");
+    return ActionRecord{ActionCode::PRINT_PLAN_STATUS, getStatus(), "", planId};
 }
 
 //--------------------------//////
@@ -95,10 +107,10 @@ AddPlan::AddPlan(const string &settlementName, const string &selectionPolicy)
 
 void AddPlan::act(Simulation &simulation)
 {
-    Settlement &settlement_to_addPlan = simulation.getSettlement(settlementName);
     SelectionPolicy *wanted_policy = nullptr;
    if (simulation.isSettlementExists(settlementName)){
-      
+      const Settlement &settlement_to_addPlan = simulation.getSettlement(settlementName);
+
       if (selectionPolicy == "bal"){
         wanted_policy = new BalancedSelection(0, 0, 0);
         simulation.addPlan(settlement_to_addPlan, wanted_policy);
@@ -128,13 +140,9 @@ void AddPlan::act(Simulation &simulation)
    }
 }
 
-const string AddPlan::toString() const
+ActionRecord AddPlan::getRecord() const
 {
-
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: AddPlan " + settlementName+ " (settlement) ERROR");
-    else
-        return ("Action: AddPlan " + settlementName + " (settlement) COMPLETED");
+    return ActionRecord{ActionCode::ADD_PLAN, getStatus(), settlementName, 0};
 }
 
 AddPlan *AddPlan::clone() const
@@ -173,12 +181,9 @@ AddSettlement *AddSettlement::clone() const
 {
     return new AddSettlement(*this);
 }
-const string AddSettlement::toString() const
+ActionRecord AddSettlement::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: AddSettlement " + settlementName + " ERROR!");
-    else
-        return ("Action: AddSettlement " + settlementName + " COMPLETED!");
+    return ActionRecord{ActionCode::ADD_SETTLEMENT, getStatus(), settlementName, 0};
 }
 
 //--------------------------//////
@@ -216,12 +221,9 @@ AddFacility *AddFacility::clone() const
 {
     return new AddFacility(*this);
 }
-const string AddFacility::toString() const
+ActionRecord AddFacility::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: AddFacility: " + facilityName +" ERROR");
-    else
-        return ("Action: AddFacility: " + facilityName +  " COMPLETED");
+    return ActionRecord{ActionCode::ADD_FACILITY, getStatus(), facilityName, 0};
 }
 
 //--------------------------//////
@@ -235,7 +237,7 @@ void ChangePlanPolicy::act(Simulation &simulation)
     if (!simulation.isPlanIdExsits(planId)) 
        error ("no planId like this.");
     else {
-    Plan &to_change = simulation.getPlan(planId);
+    Plan &to_change = simulation.getPlanForUpdate(planId);
     if (to_change.getSelectionPolicy()->toString()==newPolicy){
         error ("the plan alredy have this policy.");
     }
@@ -271,44 +273,76 @@ ChangePlanPolicy *ChangePlanPolicy::clone() const
 {
     return new ChangePlanPolicy(*this);
 }
-const string ChangePlanPolicy::toString() const
+ActionRecord ChangePlanPolicy::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: ChangePlanPolicy " + std::to_string(planId) + " ERROR.");
-    else
-        return ("Action: ChangePlanPolicy "+ std::to_string(planId) + " COMPLETED.");
+    return ActionRecord{ActionCode::CHANGE_PLAN_POLICY, getStatus(), "", planId};
 }
 
 //--------------------------//////
 // PrintActionsLog Implementation
 
-PrintActionsLog::PrintActionsLog() : BaseAction() {}
+PrintActionsLog::PrintActionsLog() : BaseAction(), range(Range::ALL), from(0), count(0) {}
+
+PrintActionsLog::PrintActionsLog(int count) : BaseAction(), range(Range::TAIL), from(0), count(count) {}
+
+PrintActionsLog::PrintActionsLog(int from, int count) : BaseAction(), range(Range::FROM), from(from), count(count) {}
 
 void PrintActionsLog::act(Simulation &simulation)
 {
-    simulation.printLog();
-    complete();
+    if (range == Range::ALL)
+    {
+        simulation.printLog();
+        complete();
+    }
+    else if (count < 0 || from < 0)
+    {
+        error("Invalid log range");
+    }
+    else
+    {
+        std::size_t end = simulation.getLogEnd();
+        std::size_t first = range == Range::TAIL ? end - std::min<std::size_t>(end, count) : from;
+        simulation.printLog(first, count);
+        complete();
+    }
 }
 
 PrintActionsLog *PrintActionsLog::clone() const
 {
     return new PrintActionsLog(*this);
 }
-const string PrintActionsLog::toString() const
+ActionRecord PrintActionsLog::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: PrintActionsLog ERROR!");
-    else
-        return ("Action: PrintActionsLog COMPLETED!");
+    return ActionRecord{ActionCode::PRINT_ACTIONS_LOG, getStatus(), "", 0};
 }
 
-// Default Constructor
-BackupSimulation::BackupSimulation() {}
+//--------------------------//////
+// PrintMemoryStats Implementation
+
+PrintMemoryStats::PrintMemoryStats() : BaseAction() {}
+
+void PrintMemoryStats::act(Simulation &simulation)
+{
+    SlabAllocator::printStats(std::cout);
+    complete();
+}
+
+PrintMemoryStats *PrintMemoryStats::clone() const
+{
+    return new PrintMemoryStats(*this);
+}
+ActionRecord PrintMemoryStats::getRecord() const
+{
+    return ActionRecord{ActionCode::PRINT_MEMORY_STATS, getStatus(), "", 0};
+}
+
+// Constructor; "default" is the snapshot used by a plain 'backup'
+BackupSimulation::BackupSimulation(const string &snapshotName) : BaseAction(), snapshotName(snapshotName) {}
 
 // Action method
 void BackupSimulation::act(Simulation &simulation)
 {
-    simulation.backup();
+    simulation.backup(snapshotName);
     complete(); // Mark the action as complete
 }
 
@@ -318,22 +352,19 @@ BackupSimulation *BackupSimulation::clone() const
     return new BackupSimulation(*this); // Create a copy of the object
 }
 
-// Convert to string method
-const string BackupSimulation::toString() const
+// Log record
+ActionRecord BackupSimulation::getRecord() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: BackupSimulation ERROR!");
-    else
-        return ("Action: BackupSimulation COMPLETED!");
+    return ActionRecord{ActionCode::BACKUP, getStatus(), snapshotName, 0};
 }
 
-// Default Constructor
-RestoreSimulation::RestoreSimulation() {}
+// Constructor; "default" is the snapshot used by a plain 'restore'
+RestoreSimulation::RestoreSimulation(const string &snapshotName) : BaseAction(), snapshotName(snapshotName) {}
 
 // Action method
 void RestoreSimulation::act(Simulation &simulation)
 {
-    if( simulation.restore()) {
+    if( simulation.restore(snapshotName)) {
     complete(); 
     }
     else {
@@ -347,11 +378,195 @@ RestoreSimulation *RestoreSimulation::clone() const
     return new RestoreSimulation(*this); // Create a copy of the object
 }
 
-// Convert to string method
-const string RestoreSimulation::toString() const
+// Log record
+ActionRecord RestoreSimulation::getRecord() const
+{
+    return ActionRecord{ActionCode::RESTORE, getStatus(), snapshotName, 0};
+}
+
+//--------------------------//////
+// PrintSnapshots Implementation
+
+PrintSnapshots::PrintSnapshots() : BaseAction() {}
+
+void PrintSnapshots::act(Simulation &simulation)
+{
+    simulation.printSnapshots();
+    complete();
+}
+
+PrintSnapshots *PrintSnapshots::clone() const
 {
-    if (getStatus() == ActionStatus::ERROR)
-        return ("Action: RestoreSimulation ERROR!");
+    return new PrintSnapshots(*this);
+}
+ActionRecord PrintSnapshots::getRecord() const
+{
+    return ActionRecord{ActionCode::PRINT_SNAPSHOTS, getStatus(), "", 0};
+}
+
+//--------------------------//////
+// PrintStats Implementation
+
+PrintStats::PrintStats(bool reset) : BaseAction(), reset(reset) {}
+
+void PrintStats::act(Simulation &simulation)
+{
+    if (reset)
+    {
+        HotPathStats::reset();
+    }
+    else
+    {
+        HotPathStats::print(std::cout);
+    }
+    complete();
+}
+
+PrintStats *PrintStats::clone() const
+{
+    return new PrintStats(*this);
+}
+ActionRecord PrintStats::getRecord() const
+{
+    return ActionRecord{ActionCode::PRINT_STATS, getStatus(), "", reset ? 1 : 0};
+}
+
+//--------------------------//////
+// TopPlans Implementation
+
+TopPlans::TopPlans(const string &metric, int count) : BaseAction(), metric(getLoggedMetric(metric)), count(count) {}
+
+string TopPlans::getLoggedMetric(const string &metric)
+{
+    Leaderboard::Metric ranked;
+    return Leaderboard::parseMetric(metric, ranked) ? metric : "unknown";
+}
+
+void TopPlans::act(Simulation &simulation)
+{
+    Leaderboard::Metric ranked;
+    if (!Leaderboard::parseMetric(metric, ranked))
+    {
+        error("no metric like this.");
+    }
+    else if (count < 0)
+    {
+        error("Invalid number of plans");
+    }
     else
-        return ("Action: RestoreSimulation COMPLETED!");
-}
\ No newline at end of file
+    {
+        vector<int> planIds;
+        simulation.getTopPlans(ranked, count, planIds);
+        std::string lines;
+        for (std::size_t i = 0; i < planIds.size(); i++)
+        {
+            const Plan &plan = simulation.getPlan(planIds[i]);
+            lines += "Rank: ";
+            lines += std::to_string(i + 1);
+            lines += ", PlanID: ";
+            lines += std::to_string(planIds[i]);
+            lines += ", SettlementName: ";
+            lines += plan.getSettlement();
+            lines += ", Score: ";
+            lines += std::to_string(Leaderboard::getScore(plan, ranked));
+            lines += '\n';
+        }
+        std::cout.write(lines.data(), lines.size());
+        complete();
+    }
+}
+
+TopPlans *TopPlans::clone() const
+{
+    return new TopPlans(*this);
+}
+ActionRecord TopPlans::getRecord() const
+{
+    return ActionRecord{ActionCode::TOP_PLANS, getStatus(), metric, count};
+}
+
+//--------------------------//////
+// QueryPlans Implementation
+
+QueryPlans::QueryPlans(const string &mode, const vector<string> &predicates)
+    : BaseAction(), mode(mode), predicates(predicates) {}
+
+void QueryPlans::act(Simulation &simulation)
+{
+    PlanFilter filter;
+    string errorMsg;
+    for (const string &predicate : predicates)
+    {
+        if (!filter.addPredicate(predicate, errorMsg))
+        {
+            error(errorMsg);
+            return;
+        }
+    }
+    if (mode != "count" && mode != "ids" && mode != "stats")
+    {
+        error("no query like " + mode);
+        return;
+    }
+    vector<int> planIds;
+    simulation.queryPlans(filter, planIds);
+    std::string lines = "Count: ";
+    lines += std::to_string(planIds.size());
+    lines += '\n';
+    if (mode == "ids")
+    {
+        for (int planId : planIds)
+        {
+            lines += "PlanID: ";
+            lines += std::to_string(planId);
+            lines += ", SettlementName: ";
+            lines += simulation.getPlan(planId).getSettlement();
+            lines += '\n';
+        }
+    }
+    else if (mode == "stats" && !planIds.empty())
+    {
+        const char *names[] = {"LifeQualityScore", "EconomyScore", "EnvironmentScore"};
+        long long sum[3] = {0, 0, 0};
+        int low[3], high[3];
+        for (std::size_t i = 0; i < planIds.size(); i++)
+        {
+            const Plan &plan = simulation.getPlan(planIds[i]);
+            const int scores[3] = {plan.getlifeQualityScore(), plan.getEconomyScore(), plan.getEnvironmentScore()};
+            for (int score = 0; score < 3; score++)
+            {
+                sum[score] += scores[score];
+                low[score] = i == 0 ? scores[score] : std::min(low[score], scores[score]);
+                high[score] = i == 0 ? scores[score] : std::max(high[score], scores[score]);
+            }
+        }
+        for (int score = 0; score < 3; score++)
+        {
+            lines += names[score];
+            lines += ": Sum ";
+            lines += std::to_string(sum[score]);
+            lines += ", Min ";
+            lines += std::to_string(low[score]);
+            lines += ", Max ";
+            lines += std::to_string(high[score]);
+            lines += ", Average ";
+            lines += std::to_string(sum[score] / static_cast<long long>(planIds.size()));
+            lines += '\n';
+        }
+    }
+    std::cout.write(lines.data(), lines.size());
+    complete();
+}
+
+QueryPlans *QueryPlans::clone() const
+{
+    return new QueryPlans(*this);
+}
+
+ActionRecord QueryPlans::getRecord() const
+{
+    // Only a known mode is logged: names are interned in the log, and
+    // predicates (or a mistyped mode) carry arbitrary text
+    const bool known = mode == "count" || mode == "ids" || mode == "stats";
+    return ActionRecord{ActionCode::QUERY_PLANS, getStatus(), known ? mode : "unknown", 0};
+}
@@ -0,0 +1,248 @@
+#include "ActionLog.h"
+#include "Action.h"
+#include "Auxiliary.h"
+#include "MemoryUsage.h"
+
+namespace
+{
+std::size_t getNameBytes(const vector<string> &names)
+{
+    std::size_t bytes = names.capacity() * sizeof(string);
+    for (const string &name : names)
+    {
+        bytes += name.capacity();
+    }
+    return bytes;
+}
+}
+
+ActionLog::Chunk::Chunk() : codes(), nameIds(), numbers(), names(1) {}
+
+ActionLog::ActionLog() : chunks(), tail(), firstChunk(0), limit(0), tailNameIds() {}
+
+ActionLog::ActionLog(const ActionLog &other)
+    : chunks(other.chunks), tail(other.tail), firstChunk(other.firstChunk), limit(other.limit), tailNameIds() {}
+
+ActionLog &ActionLog::operator=(const ActionLog &other)
+{
+    if (this != &other)
+    {
+        chunks = other.chunks;
+        tail = other.tail;
+        firstChunk = other.firstChunk;
+        limit = other.limit;
+        tailNameIds.clear();
+    }
+    return *this;
+}
+
+std::uint32_t ActionLog::internTailName(const string &name)
+{
+    if (tailNameIds.size() + 1 != tail.names.size())
+    {
+        // A copy of another log: index the names its tail came with
+        tailNameIds.clear();
+        for (std::size_t id = 1; id < tail.names.size(); id++)
+        {
+            tailNameIds.emplace(tail.names[id], static_cast<std::uint32_t>(id));
+        }
+    }
+    auto inserted = tailNameIds.emplace(name, static_cast<std::uint32_t>(tail.names.size()));
+    if (inserted.second)
+    {
+        tail.names.push_back(name);
+    }
+    return inserted.first->second;
+}
+
+void ActionLog::append(const ActionRecord &record)
+{
+    std::uint32_t nameId = record.name.empty() ? 0 : internTailName(record.name);
+    if (tail.codes.empty())
+    {
+        tail.codes.reserve(CHUNK_SIZE);
+        tail.nameIds.reserve(CHUNK_SIZE);
+        tail.numbers.reserve(CHUNK_SIZE);
+    }
+    tail.codes.push_back(static_cast<std::uint8_t>(static_cast<unsigned>(record.code) << 1 |
+                                                   (record.status == ActionStatus::ERROR ? 1u : 0u)));
+    tail.nameIds.push_back(nameId);
+    tail.numbers.push_back(record.number);
+    if (tail.codes.size() == CHUNK_SIZE)
+    {
+        // Seal the chunk; from now on copies only share it
+        chunks.push_back(std::make_shared<const Chunk>(std::move(tail)));
+        tail = Chunk();
+        tailNameIds.clear();
+        dropOldChunks();
+    }
+}
+
+void ActionLog::setLimit(std::size_t maxEntries)
+{
+    limit = maxEntries;
+    dropOldChunks();
+}
+
+std::size_t ActionLog::getEnd() const
+{
+    return firstChunk + chunks.size() * CHUNK_SIZE + tail.codes.size();
+}
+
+std::size_t ActionLog::getBegin() const
+{
+    std::size_t end = getEnd();
+    if (limit != 0 && end - firstChunk > limit)
+    {
+        return end - limit;
+    }
+    return firstChunk;
+}
+
+void ActionLog::dropOldChunks()
+{
+    // Free the full chunks that lie entirely before the kept entries
+    std::size_t begin = getBegin();
+    std::size_t dropped = 0;
+    while (dropped < chunks.size() && firstChunk + (dropped + 1) * CHUNK_SIZE <= begin)
+    {
+        dropped++;
+    }
+    if (dropped != 0)
+    {
+        chunks.erase(chunks.begin(), chunks.begin() + dropped);
+        firstChunk += dropped * CHUNK_SIZE;
+    }
+}
+
+void ActionLog::print(std::ostream &out, std::size_t from, std::size_t count) const
+{
+    std::size_t end = getEnd();
+    if (from >= end)
+    {
+        return;
+    }
+    // End of the requested range first, so evicted entries shorten it instead of shifting it
+    std::size_t stop = count < end - from ? from + count : end;
+    if (from < getBegin())
+    {
+        from = getBegin();
+    }
+    string lines;
+    for (std::size_t index = from; index < stop; index++)
+    {
+        std::size_t offset = index - firstChunk;
+        std::size_t chunk = offset / CHUNK_SIZE;
+        const Chunk &entries = chunk < chunks.size() ? *chunks[chunk] : tail;
+        std::size_t position = offset % CHUNK_SIZE;
+        std::uint8_t code = entries.codes[position];
+        appendDescription(lines, static_cast<ActionCode>(code >> 1),
+                          (code & 1) ? ActionStatus::ERROR : ActionStatus::COMPLETED,
+                          entries.names[entries.nameIds[position]], entries.numbers[position]);
+        lines += '\n';
+        if (lines.size() >= 64 * 1024)
+        {
+            out.write(lines.data(), lines.size());
+            lines.clear();
+        }
+    }
+    out.write(lines.data(), lines.size());
+}
+
+void ActionLog::countMemory(MemoryUsage &usage) const
+{
+    const std::size_t entryBytes = sizeof(std::uint8_t) + sizeof(std::uint32_t) + sizeof(std::int32_t);
+    std::size_t bytes = chunks.capacity() * sizeof(chunks[0]) + tail.codes.capacity() * entryBytes +
+                        getNameBytes(tail.names) + tailNameIds.size() * (sizeof(string) + sizeof(std::uint32_t));
+    for (const auto &entry : tailNameIds)
+    {
+        bytes += entry.first.capacity();
+    }
+    usage.visit(this, bytes);
+    for (const std::shared_ptr<const Chunk> &chunk : chunks)
+    {
+        usage.visit(chunk.get(), sizeof(Chunk) + CHUNK_SIZE * entryBytes + getNameBytes(chunk->names));
+    }
+}
+
+string ActionLog::describe(const ActionRecord &record)
+{
+    string text;
+    appendDescription(text, record.code, record.status, record.name, record.number);
+    return text;
+}
+
+void ActionLog::appendDescription(string &out, ActionCode code, ActionStatus status, const string &name, int number)
+{
+    const bool failed = status == ActionStatus::ERROR;
+    out += "Action: ";
+    switch (code)
+    {
+    case ActionCode::STEP:
+        out += "Step ";
+        Auxiliary::appendInt(out, number);
+        out += failed ? " ERROR" : " COMPLETED";
+        break;
+    case ActionCode::ADD_PLAN:
+        out += "AddPlan ";
+        out += name;
+        out += failed ? " (settlement) ERROR" : " (settlement) COMPLETED";
+        break;
+    case ActionCode::ADD_SETTLEMENT:
+        out += "AddSettlement ";
+        out += name;
+        out += failed ? " ERROR!" : " COMPLETED!";
+        break;
+    case ActionCode::ADD_FACILITY:
+        out += "AddFacility: ";
+        out += name;
+        out += failed ? " ERROR" : " COMPLETED";
+        break;
+    case ActionCode::PRINT_PLAN_STATUS:
+        out += "PrintPlanStatus of Plan";
+        Auxiliary::appendInt(out, number);
+        out += failed ? " ERROR" : " COMPLETED";
+        break;
+    case ActionCode::CHANGE_PLAN_POLICY:
+        out += "ChangePlanPolicy ";
+        Auxiliary::appendInt(out, number);
+        out += failed ? " ERROR." : " COMPLETED.";
+        break;
+    case ActionCode::PRINT_ACTIONS_LOG:
+        out += failed ? "PrintActionsLog ERROR!" : "PrintActionsLog COMPLETED!";
+        break;
+    case ActionCode::PRINT_MEMORY_STATS:
+        out += failed ? "PrintMemoryStats ERROR!" : "PrintMemoryStats COMPLETED!";
+        break;
+    case ActionCode::BACKUP:
+    case ActionCode::RESTORE:
+        out += code == ActionCode::BACKUP ? "BackupSimulation " : "RestoreSimulation ";
+        // A plain 'backup'/'restore' uses the "default" snapshot and does not name it
+        if (name != "default")
+        {
+            out += name;
+            out += ' ';
+        }
+        out += failed ? "ERROR!" : "COMPLETED!";
+        break;
+    case ActionCode::PRINT_SNAPSHOTS:
+        out += failed ? "PrintSnapshots ERROR!" : "PrintSnapshots COMPLETED!";
+        break;
+    case ActionCode::PRINT_STATS:
+        out += number != 0 ? "ResetStats " : "PrintStats "; // number: whether the counters were reset
+        out += failed ? "ERROR!" : "COMPLETED!";
+        break;
+    case ActionCode::TOP_PLANS:
+        out += "TopPlans ";
+        out += name;
+        out += ' ';
+        Auxiliary::appendInt(out, number);
+        out += failed ? " ERROR!" : " COMPLETED!";
+        break;
+    case ActionCode::QUERY_PLANS:
+        out += "QueryPlans ";
+        out += name;
+        out += failed ? " ERROR!" : " COMPLETED!";
+        break;
+    }
+}
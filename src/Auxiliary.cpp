@@ -1,4 +1,8 @@
 #include "Auxiliary.h"
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 /*
 This is a 'static' method that receives a string(line) and returns a vector of the string's arguments.
 
@@ -20,3 +24,103 @@ std::vector<std::string> Auxiliary::parseArguments(const std::string &line)
 
     return arguments;
 }
+
+/*
+Same split as parseArguments, but for the characters in [begin, end) and without copying them:
+the first maxTokens words are stored in tokens, and the number of words is returned
+(which can be larger than maxTokens).
+*/
+std::size_t Auxiliary::splitArguments(const char *begin, const char *end, Token *tokens, std::size_t maxTokens)
+{
+    std::size_t count = 0;
+    const char *position = begin;
+    while (true)
+    {
+        while (position != end && std::isspace(static_cast<unsigned char>(*position)))
+        {
+            position++;
+        }
+        if (position == end)
+        {
+            return count;
+        }
+        const char *wordStart = position;
+        while (position != end && !std::isspace(static_cast<unsigned char>(*position)))
+        {
+            position++;
+        }
+        if (count < maxTokens)
+        {
+            tokens[count].data = wordStart;
+            tokens[count].length = position - wordStart;
+        }
+        count++;
+    }
+}
+
+/*
+Reads the integer at the start of token without allocating. Behaves like std::stoi: an optional
+sign and at least one digit are required, anything after the digits is ignored, and the same
+exceptions are thrown when there is no number or it does not fit in an int.
+*/
+int Auxiliary::parseInt(const Token &token)
+{
+    std::size_t i = 0;
+    bool negative = false;
+    if (i < token.length && (token.data[i] == '+' || token.data[i] == '-'))
+    {
+        negative = token.data[i] == '-';
+        i++;
+    }
+    if (i == token.length || token.data[i] < '0' || token.data[i] > '9')
+    {
+        throw std::invalid_argument("stoi");
+    }
+    const long long limit = negative ? -static_cast<long long>(std::numeric_limits<int>::min()) : std::numeric_limits<int>::max();
+    long long value = 0;
+    bool overflow = false;
+    for (; i < token.length && token.data[i] >= '0' && token.data[i] <= '9'; i++)
+    {
+        value = value * 10 + (token.data[i] - '0');
+        if (value > limit)
+        {
+            overflow = true;
+            value = limit; // keep reading the digits, as stoi does
+        }
+    }
+    if (overflow)
+    {
+        throw std::out_of_range("stoi");
+    }
+    return static_cast<int>(negative ? -value : value);
+}
+
+bool Auxiliary::Token::equals(const char *text) const
+{
+    return std::strlen(text) == length && std::memcmp(text, data, length) == 0;
+}
+
+std::string Auxiliary::Token::toString() const
+{
+    return std::string(data, length);
+}
+
+// Appends the decimal digits of value without a temporary string
+void Auxiliary::appendInt(std::string &out, int value)
+{
+    char digits[12];
+    char *end = digits + sizeof(digits);
+    char *position = end;
+    // Work with the magnitude as unsigned so INT_MIN is handled too
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do
+    {
+        *--position = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+    {
+        *--position = '-';
+    }
+    out.append(position, end);
+}
@@ -1,4 +1,5 @@
 #include "Facility.h"
+#include "Settlement.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -38,17 +39,49 @@ FacilityType *FacilityType::clone() const
 }
 
 // class Facility
-Facility::Facility(const string &name, const string &settlementName, const FacilityCategory category,
-                   const int price, const int lifeQuality_score, const int economy_score, const int environment_score)
-    : FacilityType(name, category, price, lifeQuality_score, economy_score, environment_score),
-      settlementName(settlementName), status(FacilityStatus::UNDER_CONSTRUCTIONS), timeLeft(price) {}
+Facility::Facility(const vector<FacilityType> &catalog, int typeIndex, const Settlement &settlement)
+    : catalog(&catalog), typeIndex(typeIndex), settlement(&settlement),
+      status(FacilityStatus::UNDER_CONSTRUCTIONS), timeLeft(catalog[typeIndex].getCost()) {}
 
-Facility::Facility(const FacilityType &type, const string &settlementName)
-    : FacilityType(type), settlementName(settlementName), status(FacilityStatus::UNDER_CONSTRUCTIONS), timeLeft(price) {}
+Facility::Facility(const vector<FacilityType> &catalog, int typeIndex, const Settlement &settlement, FacilityStatus status, int timeLeft)
+    : catalog(&catalog), typeIndex(typeIndex), settlement(&settlement), status(status), timeLeft(timeLeft) {}
+
+const FacilityType &Facility::getType() const
+{
+    return (*catalog)[typeIndex];
+}
+int Facility::getTypeIndex() const
+{
+    return typeIndex;
+}
+const string &Facility::getName() const
+{
+    return getType().getName();
+}
+int Facility::getCost() const
+{
+    return getType().getCost();
+}
+int Facility::getLifeQualityScore() const
+{
+    return getType().getLifeQualityScore();
+}
+int Facility::getEnvironmentScore() const
+{
+    return getType().getEnvironmentScore();
+}
+int Facility::getEconomyScore() const
+{
+    return getType().getEconomyScore();
+}
+FacilityCategory Facility::getCategory() const
+{
+    return getType().getCategory();
+}
 
 const string &Facility::getSettlementName() const
 {
-    return settlementName;
+    return settlement->getName();
 }
 
 const int Facility::getTimeLeft() const
@@ -0,0 +1,100 @@
+#include "FacilityCatalog.h"
+#include "MemoryUsage.h"
+#include <atomic>
+
+namespace
+{
+    std::atomic<unsigned long long> nextVersion(1);
+    const int CATEGORY_COUNT = 3; // values of FacilityCategory
+}
+
+FacilityCatalog::Storage::Storage()
+    : types(), nextInCategory(CATEGORY_COUNT), lastInCategory(CATEGORY_COUNT, -1) {}
+
+// Appends even if the name is taken (the config file may repeat a name)
+void FacilityCatalog::Storage::append(const FacilityType &facility)
+{
+    const int index = static_cast<int>(types.size());
+    types.push_back(facility);
+    for (vector<int> &next : nextInCategory)
+    {
+        next.push_back(-1);
+    }
+    // Positions after the previous facility of this category now lead here.
+    // Each entry is filled in once, so appending stays amortized O(1).
+    const int category = static_cast<int>(facility.getCategory());
+    if (category < 0 || category >= CATEGORY_COUNT)
+    {
+        return; // the config file doesn't check categories; no policy looks for this one
+    }
+    for (int i = lastInCategory[category] + 1; i <= index; i++)
+    {
+        nextInCategory[category][i] = index;
+    }
+    lastInCategory[category] = index;
+}
+
+FacilityCatalog::FacilityCatalog()
+    : storage(std::make_shared<Storage>()), length(0), indexByName(), version(nextVersion++) {}
+
+const vector<FacilityType> &FacilityCatalog::getTypes() const
+{
+    return storage->types;
+}
+
+void FacilityCatalog::reserve(std::size_t capacity)
+{
+    if (storage->types.size() != length)
+    {
+        return;
+    }
+    storage->types.reserve(capacity);
+    for (vector<int> &next : storage->nextInCategory)
+    {
+        next.reserve(capacity);
+    }
+    indexByName.reserve(capacity);
+}
+
+int FacilityCatalog::find(const string &name) const
+{
+    return indexByName.find(name);
+}
+
+// Lookups keep returning the first type with a name, as the old linear scan did
+void FacilityCatalog::push_back(const FacilityType &facility)
+{
+    if (storage->types.size() != length)
+    {
+        detach();
+    }
+    storage->append(facility);
+    length++;
+    indexByName.push_back(facility.getName());
+    version = nextVersion++;
+}
+
+// Another copy appended types this one must not see; rebuild our own prefix
+void FacilityCatalog::detach()
+{
+    std::shared_ptr<Storage> own = std::make_shared<Storage>();
+    own->types.reserve(length);
+    for (std::size_t i = 0; i < length; i++)
+    {
+        own->append(storage->types[i]);
+    }
+    storage = own;
+}
+
+void FacilityCatalog::countMemory(MemoryUsage &usage) const
+{
+    usage.visit(this, sizeof(FacilityCatalog));
+    usage.visit(storage.get(), sizeof(Storage) + storage->types.capacity() * sizeof(FacilityType) +
+                                   storage->nextInCategory.size() * storage->types.capacity() * sizeof(int));
+    indexByName.countMemory(usage);
+}
+
+unsigned long long FacilityCatalog::getVersion() const
+{
+    return version;
+}
@@ -0,0 +1,43 @@
+#include "FacilityHistory.h"
+#include "MemoryUsage.h"
+
+FacilityHistory::FacilityHistory() : chunks(), tail() {}
+
+std::size_t FacilityHistory::size() const
+{
+    return chunks.size() * CHUNK_SIZE + tail.size();
+}
+
+int FacilityHistory::operator[](std::size_t index) const
+{
+    std::size_t chunk = index / CHUNK_SIZE;
+    if (chunk < chunks.size())
+    {
+        return (*chunks[chunk])[index % CHUNK_SIZE];
+    }
+    return tail[index % CHUNK_SIZE];
+}
+
+void FacilityHistory::push_back(int typeIndex)
+{
+    if (tail.empty())
+    {
+        tail.reserve(CHUNK_SIZE);
+    }
+    tail.push_back(typeIndex);
+    if (tail.size() == CHUNK_SIZE)
+    {
+        // Seal the chunk; from now on copies only share it
+        chunks.push_back(std::make_shared<const vector<int>>(std::move(tail)));
+        tail = vector<int>();
+    }
+}
+
+void FacilityHistory::countMemory(MemoryUsage &usage) const
+{
+    usage.visit(this, chunks.capacity() * sizeof(chunks[0]) + tail.capacity() * sizeof(int));
+    for (const std::shared_ptr<const vector<int>> &chunk : chunks)
+    {
+        usage.visit(chunk.get(), sizeof(*chunk) + CHUNK_SIZE * sizeof(int));
+    }
+}
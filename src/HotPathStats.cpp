@@ -0,0 +1,144 @@
+#include "HotPathStats.h"
+
+namespace
+{
+    const char *PROBE_NAMES[] = {"Simulation::step", "Plan::step", "selectFacility", "backup", "restore"};
+    const char *ACTION_NAMES[] = {"Step", "AddPlan", "AddSettlement", "AddFacility", "PrintPlanStatus", "ChangePlanPolicy",
+                                  "PrintActionsLog", "PrintMemoryStats", "BackupSimulation", "RestoreSimulation",
+                                  "PrintSnapshots", "PrintStats", "TopPlans", "QueryPlans"};
+
+}
+
+// Sampled counters scale the time of their timed calls up to all calls. Their
+// longest call is only known among the timed ones, so it is printed as such,
+// next to how many calls were timed.
+void HotPathStats::printCounter(std::ostream &out, const char *kind, const char *name, const Counter &counter)
+{
+    std::uint64_t mean = counter.timedCalls == 0 ? 0 : counter.timedNanoseconds / counter.timedCalls;
+    bool sampled = counter.timedCalls != counter.calls;
+    std::uint64_t total = sampled ? mean * counter.calls : counter.timedNanoseconds;
+    out << kind << ": " << name << ", Calls: " << counter.calls << ", TotalNs: " << total;
+    if (sampled)
+    {
+        out << ", TimedCalls: " << counter.timedCalls << ", SampledMaxNs: " << counter.maxNanoseconds;
+    }
+    else
+    {
+        out << ", MaxNs: " << counter.maxNanoseconds;
+    }
+    out << ", MeanNs: " << mean << "\n";
+}
+
+thread_local HotPathStats::Block *HotPathStats::localBlock = nullptr;
+
+HotPathStats::HotPathStats() : blocks(), mutex() {}
+
+HotPathStats &HotPathStats::instance()
+{
+    static HotPathStats stats;
+    return stats;
+}
+
+// First count on this thread: give it a zeroed block
+HotPathStats::Block &HotPathStats::createLocal()
+{
+    HotPathStats &stats = instance();
+    std::unique_ptr<Block> block(new Block());
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    localBlock = block.get();
+    stats.blocks.push_back(std::move(block));
+    return *localBlock;
+}
+
+void HotPathStats::Counter::add(std::uint64_t nanoseconds)
+{
+    calls++;
+    addTimed(nanoseconds);
+}
+
+void HotPathStats::Counter::addTimed(std::uint64_t nanoseconds)
+{
+    timedCalls++;
+    timedNanoseconds += nanoseconds;
+    if (nanoseconds > maxNanoseconds)
+    {
+        maxNanoseconds = nanoseconds;
+    }
+}
+
+void HotPathStats::Counter::merge(const Counter &other)
+{
+    calls += other.calls;
+    timedCalls += other.timedCalls;
+    timedNanoseconds += other.timedNanoseconds;
+    if (other.maxNanoseconds > maxNanoseconds)
+    {
+        maxNanoseconds = other.maxNanoseconds;
+    }
+}
+
+void HotPathStats::record(Probe probe, std::uint64_t nanoseconds)
+{
+    local().probes[static_cast<int>(probe)].add(nanoseconds);
+}
+
+void HotPathStats::recordAction(ActionCode code, std::uint64_t nanoseconds)
+{
+    local().actions[static_cast<int>(code)].add(nanoseconds);
+}
+
+void HotPathStats::addSimulatedSteps(std::uint64_t steps)
+{
+    local().simulatedSteps += steps;
+}
+
+void HotPathStats::print(std::ostream &out)
+{
+    HotPathStats &stats = instance();
+    Block total = Block();
+    {
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        for (const std::unique_ptr<Block> &block : stats.blocks)
+        {
+            for (int i = 0; i < PROBE_COUNT; i++)
+            {
+                total.probes[i].merge(block->probes[i]);
+            }
+            for (int i = 0; i < ACTION_COUNT; i++)
+            {
+                total.actions[i].merge(block->actions[i]);
+            }
+            total.facilitiesCreated += block->facilitiesCreated;
+            total.facilitiesCompleted += block->facilitiesCompleted;
+            total.simulatedSteps += block->simulatedSteps;
+        }
+    }
+
+    out << "Hot path statistics:\n";
+    for (int i = 0; i < PROBE_COUNT; i++)
+    {
+        printCounter(out, "Probe", PROBE_NAMES[i], total.probes[i]);
+    }
+    for (int i = 0; i < ACTION_COUNT; i++)
+    {
+        if (total.actions[i].calls != 0)
+        {
+            printCounter(out, "Action", ACTION_NAMES[i], total.actions[i]);
+        }
+    }
+    std::uint64_t steps = total.simulatedSteps;
+    out << "SimulatedSteps: " << steps << ", FacilitiesCreated: " << total.facilitiesCreated
+        << ", FacilitiesCompleted: " << total.facilitiesCompleted
+        << ", CreatedPerStep: " << (steps == 0 ? 0.0 : static_cast<double>(total.facilitiesCreated) / steps)
+        << ", CompletedPerStep: " << (steps == 0 ? 0.0 : static_cast<double>(total.facilitiesCompleted) / steps) << "\n";
+}
+
+void HotPathStats::reset()
+{
+    HotPathStats &stats = instance();
+    std::lock_guard<std::mutex> lock(stats.mutex);
+    for (const std::unique_ptr<Block> &block : stats.blocks)
+    {
+        *block = Block();
+    }
+}
@@ -0,0 +1,239 @@
+#include "Leaderboard.h"
+#include <algorithm>
+#include <queue>
+
+Leaderboard::Leaderboard() : built(false), rankings(), changedPlans(), isChanged() {}
+
+bool Leaderboard::parseMetric(const string &name, Metric &metric)
+{
+    if (name == "life")
+        metric = Metric::LIFE_QUALITY;
+    else if (name == "economy")
+        metric = Metric::ECONOMY;
+    else if (name == "environment")
+        metric = Metric::ENVIRONMENT;
+    else if (name == "total")
+        metric = Metric::TOTAL;
+    else if (name == "balance")
+        metric = Metric::BALANCE;
+    else
+        return false;
+    return true;
+}
+
+long long Leaderboard::getScore(const Plan &plan, Metric metric)
+{
+    long long life = plan.getlifeQualityScore();
+    long long economy = plan.getEconomyScore();
+    long long environment = plan.getEnvironmentScore();
+    switch (metric)
+    {
+    case Metric::LIFE_QUALITY:
+        return life;
+    case Metric::ECONOMY:
+        return economy;
+    case Metric::ENVIRONMENT:
+        return environment;
+    case Metric::TOTAL:
+        return life + economy + environment;
+    default:
+        return std::max(life, std::max(economy, environment)) - std::min(life, std::min(economy, environment));
+    }
+}
+
+long long Leaderboard::getKey(long long score, Metric metric)
+{
+    return metric == Metric::BALANCE ? score : -score;
+}
+
+bool Leaderboard::isBuilt() const
+{
+    return built;
+}
+
+Leaderboard::Ranking::Ranking() : keys(), best(), leafCount(0) {}
+
+int Leaderboard::Ranking::better(int first, int second) const
+{
+    if (first < 0)
+        return second;
+    if (second < 0)
+        return first;
+    if (keys[first] != keys[second])
+        return keys[first] < keys[second] ? first : second;
+    return first < second ? first : second;
+}
+
+void Leaderboard::Ranking::update(int planId, long long key)
+{
+    keys[planId] = key;
+    for (std::size_t node = (leafCount + planId) / 2; node >= 1; node /= 2)
+    {
+        int winner = better(best[2 * node], best[2 * node + 1]);
+        if (winner == best[node] && winner != planId)
+        {
+            break; // nothing above can change either
+        }
+        best[node] = winner;
+    }
+}
+
+void Leaderboard::Ranking::rebuild()
+{
+    for (std::size_t node = leafCount - 1; node >= 1; node--)
+    {
+        best[node] = better(best[2 * node], best[2 * node + 1]);
+    }
+}
+
+void Leaderboard::clear()
+{
+    built = false;
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        rankings[m] = Ranking();
+    }
+    changedPlans.clear();
+    isChanged.clear();
+}
+
+void Leaderboard::markChanged(const vector<int> &planIds)
+{
+    if (!built)
+    {
+        return; // the next build reads every plan anyway
+    }
+    for (int planId : planIds)
+    {
+        if (!isChanged[planId])
+        {
+            isChanged[planId] = 1;
+            changedPlans.push_back(planId);
+        }
+    }
+}
+
+void Leaderboard::markAdded(int planId)
+{
+    if (!built)
+    {
+        return;
+    }
+    if (static_cast<std::size_t>(planId) >= rankings[0].leafCount)
+    {
+        clear(); // out of leaves; the next query builds trees twice the size
+        return;
+    }
+    isChanged.push_back(1);
+    changedPlans.push_back(planId);
+}
+
+void Leaderboard::build(const CowVector<Plan> &plans)
+{
+    clear();
+    std::size_t count = plans.size();
+    std::size_t leafCount = 1;
+    while (leafCount < count)
+    {
+        leafCount *= 2;
+    }
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        Metric metric = static_cast<Metric>(m);
+        Ranking &ranking = rankings[m];
+        ranking.leafCount = leafCount;
+        ranking.keys.resize(leafCount);
+        ranking.best.assign(2 * leafCount, -1);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            ranking.keys[i] = getKey(getScore(plans[i], metric), metric);
+            ranking.best[leafCount + i] = static_cast<int>(i);
+        }
+        ranking.rebuild();
+    }
+    isChanged.assign(count, 0);
+    built = true;
+}
+
+void Leaderboard::applyChanges(const CowVector<Plan> &plans)
+{
+    if (changedPlans.empty())
+    {
+        return;
+    }
+    // Past about one change per tree level it is cheaper to redo every node once
+    std::size_t leafCount = rankings[0].leafCount;
+    std::size_t depth = 1;
+    while ((std::size_t(1) << depth) < leafCount)
+    {
+        depth++;
+    }
+    bool rebuild = changedPlans.size() * depth > leafCount;
+    for (int m = 0; m < METRIC_COUNT; m++)
+    {
+        Metric metric = static_cast<Metric>(m);
+        Ranking &ranking = rankings[m];
+        for (int planId : changedPlans)
+        {
+            long long key = getKey(getScore(plans[planId], metric), metric);
+            if (rebuild)
+            {
+                ranking.keys[planId] = key;
+                ranking.best[leafCount + planId] = planId;
+            }
+            else if (key != ranking.keys[planId] || ranking.best[leafCount + planId] != planId)
+            {
+                ranking.best[leafCount + planId] = planId;
+                ranking.update(planId, key);
+            }
+        }
+        if (rebuild)
+        {
+            ranking.rebuild();
+        }
+    }
+    for (int planId : changedPlans)
+    {
+        isChanged[planId] = 0;
+    }
+    changedPlans.clear();
+}
+
+void Leaderboard::getTop(const CowVector<Plan> &plans, Metric metric, std::size_t count, vector<int> &planIds)
+{
+    if (!built)
+    {
+        build(plans);
+    }
+    applyChanges(plans);
+    const Ranking &ranking = rankings[static_cast<int>(metric)];
+    // Best-first over subtrees: take the best plan of the best pending subtree,
+    // then queue the subtrees hanging off the path down to it. Pending
+    // subtrees are disjoint, so their best plans all differ.
+    auto worse = [&ranking](int first, int second)
+    {
+        return ranking.better(ranking.best[first], ranking.best[second]) == ranking.best[second];
+    };
+    std::priority_queue<int, vector<int>, decltype(worse)> pending(worse);
+    if (ranking.best[1] >= 0)
+    {
+        pending.push(1);
+    }
+    std::size_t leafCount = ranking.leafCount;
+    while (planIds.size() < count && !pending.empty())
+    {
+        std::size_t node = pending.top();
+        pending.pop();
+        int planId = ranking.best[node];
+        planIds.push_back(planId);
+        while (node < leafCount)
+        {
+            std::size_t next = ranking.best[2 * node] == planId ? 2 * node : 2 * node + 1;
+            if (ranking.best[next ^ 1] >= 0)
+            {
+                pending.push(next ^ 1);
+            }
+            node = next;
+        }
+    }
+}
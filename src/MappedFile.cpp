@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const string &path)
+    : data(nullptr), size(0), opened(false), mapped(false), contents()
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            if (info.st_size == 0)
+            {
+                opened = true; // nothing to map
+            }
+            else
+            {
+                void *address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED)
+                {
+                    ::madvise(address, info.st_size, MADV_SEQUENTIAL);
+                    data = static_cast<const char *>(address);
+                    size = static_cast<std::size_t>(info.st_size);
+                    opened = true;
+                    mapped = true;
+                }
+            }
+        }
+        ::close(fd);
+        if (opened)
+        {
+            return;
+        }
+    }
+
+    // Not a regular file, or it could not be mapped: read it the ordinary way
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    data = contents.data();
+    size = contents.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapped)
+    {
+        ::munmap(const_cast<char *>(data), size);
+    }
+}
+
+bool MappedFile::isOpen() const
+{
+    return opened;
+}
+
+const char *MappedFile::getData() const
+{
+    return data;
+}
+
+std::size_t MappedFile::getSize() const
+{
+    return size;
+}
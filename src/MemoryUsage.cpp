@@ -0,0 +1,75 @@
+#include "MemoryUsage.h"
+
+MemoryUsage::MemoryUsage() : entries(), mode(Mode::ADD), bytes(0), measuredBytes(0) {}
+
+void MemoryUsage::setMode(Mode mode)
+{
+    this->mode = mode;
+    measuredBytes = 0;
+}
+
+// Visiting an object twice for one copy counts it as held twice, which the
+// matching REMOVE undoes; EXCLUDE and INCLUDE don't count holders at all
+void MemoryUsage::visit(const void *object, std::size_t bytes)
+{
+    if (mode == Mode::ADD)
+    {
+        Entry &entry = entries.insert(std::make_pair(object, Entry{bytes, 0, false})).first->second;
+        if (entry.holders++ == 0)
+        {
+            this->bytes += entry.bytes;
+        }
+        return;
+    }
+    std::unordered_map<const void *, Entry>::iterator it = entries.find(object);
+    if (it == entries.end())
+    {
+        return;
+    }
+    Entry &entry = it->second;
+    switch (mode)
+    {
+    case Mode::REMOVE:
+        if (--entry.holders == 0)
+        {
+            if (!entry.excluded)
+            {
+                this->bytes -= entry.bytes;
+            }
+            entries.erase(it);
+        }
+        break;
+    case Mode::EXCLUDE:
+        if (!entry.excluded)
+        {
+            entry.excluded = true;
+            this->bytes -= entry.bytes;
+        }
+        break;
+    case Mode::INCLUDE:
+        if (entry.excluded)
+        {
+            entry.excluded = false;
+            this->bytes += entry.bytes;
+        }
+        break;
+    case Mode::MEASURE:
+        if (entry.holders == 1 && !entry.excluded)
+        {
+            measuredBytes += entry.bytes;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+std::size_t MemoryUsage::getBytes() const
+{
+    return bytes;
+}
+
+std::size_t MemoryUsage::getMeasuredBytes() const
+{
+    return measuredBytes;
+}
@@ -0,0 +1,47 @@
+#include "NameIndex.h"
+#include "MemoryUsage.h"
+
+NameIndex::Names::Names() : positions(), length(0) {}
+
+NameIndex::NameIndex() : names(std::make_shared<Names>()), length(0) {}
+
+void NameIndex::push_back(const string &name)
+{
+    if (names->length != length)
+    {
+        detach();
+    }
+    names->positions.insert(std::make_pair(name, static_cast<int>(length)));
+    length++;
+    names->length = length;
+}
+
+void NameIndex::reserve(std::size_t capacity)
+{
+    if (names->length == length)
+    {
+        names->positions.reserve(capacity);
+    }
+}
+
+// Another copy appended names this one must not see; keep only our own
+void NameIndex::detach()
+{
+    std::shared_ptr<Names> own = std::make_shared<Names>();
+    own->positions.reserve(length);
+    for (const std::pair<const string, int> &entry : names->positions)
+    {
+        if (static_cast<std::size_t>(entry.second) < length)
+        {
+            own->positions.insert(entry);
+        }
+    }
+    own->length = length;
+    names = own;
+}
+
+void NameIndex::countMemory(MemoryUsage &usage) const
+{
+    usage.visit(names.get(), sizeof(Names) + names->positions.bucket_count() * sizeof(void *) +
+                                 names->positions.size() * (sizeof(std::pair<const string, int>) + 2 * sizeof(void *)));
+}
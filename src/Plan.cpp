@@ -1,43 +1,44 @@
 #include "Plan.h"
 #include "Settlement.h"
+#include "Auxiliary.h"
+#include "HotPathStats.h"
+#include "MemoryUsage.h"
 #include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace
+{
+    // Plan state remembered at a fill step while looking for a repeating cycle
+    struct CycleMark
+    {
+        int stepsLeft;
+        int life_quality_score, economy_score, environment_score;
+        std::size_t facilityCount;
+    };
+
+    // Give up on cycle detection after this many distinct fill states
+    const std::size_t MAX_CYCLE_MARKS = 4096;
+}
 
 Plan::Plan(const int planId,
            const Settlement &settlement,
-           SelectionPolicy *selectionPolicy,
-           const vector<FacilityType> &facilityOptions)
+           SelectionPolicy *selectionPolicy)
     : plan_id(planId),
       settlement(settlement),
       selectionPolicy(selectionPolicy),
       status(PlanStatus::AVALIABLE), 
+      resumedRestore(0),
       facilities(),                     // Explicitly initialize as empty (optional, default behavior)
-      underConstruction(), 
-      facilityOptions(facilityOptions), 
+      constructionTypes(),
+      constructionTimeLeft(),
+      constructionStatus(),
       life_quality_score(0),
       economy_score(0),
       environment_score(0)
 {
 }
-Plan::Plan(const int planId,
-           const Settlement &settlement,
-           SelectionPolicy *selectionPolicy,
-           const std::vector<FacilityType> &facilityOptions,
-           int life_quality_score,
-           int economy_score,
-           int environment_score,
-           std::vector<Facility *> facilities,
-           std::vector<Facility *> underConstruction)
-    : Plan(planId, settlement, selectionPolicy, facilityOptions) // Delegate to first constructor
-{
-    // Additional initialization
-    this->life_quality_score = life_quality_score;
-    this->economy_score = economy_score;
-    this->environment_score = environment_score;
-    this->facilities = std::move(facilities);
-    this->underConstruction = std::move(underConstruction);
-}
-
 const int Plan::getlifeQualityScore() const
 {
     return life_quality_score;
@@ -51,22 +52,11 @@ const int Plan::getEconomyScore() const
     return economy_score;
 }
 
-const std::vector<Facility *> &Plan::getUnderConstruction() const
+int Plan::getUnderConstructionCount() const
 {
-    return underConstruction;
+    return constructionTypes.size();
 }
 
-void Plan::addFacility(Facility *facility)
-{
-    if (facility->getStatus() == FacilityStatus::OPERATIONAL)
-    {
-        facilities.push_back(facility);
-    }
-    else
-    {
-        underConstruction.push_back(facility);
-    }
-}
 void Plan::printStatus()
 {
     switch (status)
@@ -87,39 +77,72 @@ void Plan::setSelectionPolicy(SelectionPolicy *newSelectionPolicy)
     delete selectionPolicy;
     selectionPolicy = newSelectionPolicy;
 }
-void Plan::step()
+void Plan::step(const FacilityCatalog &catalog)
 {
+    HotPathStats::SampledTimer timer(HotPathStats::Probe::PLAN_STEP);
+    const vector<FacilityType> &facilityOptions = catalog.getTypes();
+    const int capacity = static_cast<int>(settlement.getType()) + 1;
     if (status == PlanStatus::BUSY)
     {
-        // If the status of the plan is busy, iterate through all facilities and step them
-        for (std::vector<Facility*>::size_type i=0; i < underConstruction.size(); ++i)
+        // Step every facility under construction in one pass over the packed arrays.
+        // Finished facilities are promoted to the operational list and the rest are
+        // compacted in place, keeping their original order.
+        std::vector<int>::size_type kept = 0;
+        for (std::vector<int>::size_type i = 0; i < constructionTypes.size(); ++i)
         {
-            if (underConstruction[i]->step() == FacilityStatus::OPERATIONAL)
+            if (constructionTimeLeft[i] > 2)
+            {
+                constructionTimeLeft[i]--; // Same countdown as Facility::step
+            }
+            else
+            {
+                constructionStatus[i] = FacilityStatus::OPERATIONAL;
+            }
+
+            if (constructionStatus[i] == FacilityStatus::OPERATIONAL)
+            {
+                const FacilityType &type = facilityOptions[constructionTypes[i]];
+                facilities.push_back(constructionTypes[i]);
+                // update the scores
+                life_quality_score += type.getLifeQualityScore();
+                economy_score += type.getEconomyScore();
+                environment_score += type.getEnvironmentScore();
+            }
+            else
             {
-                facilities.push_back(underConstruction[i]); // Move the facility to operational list
-                                                            // update the scores
-                life_quality_score += underConstruction[i]->getLifeQualityScore();
-                economy_score += underConstruction[i]->getEconomyScore();
-                environment_score += underConstruction[i]->getEnvironmentScore();
-                underConstruction.erase(underConstruction.begin() + i); // Remove the facility from underConstruction
-                --i;                                                    // Decrement to avoid skipping the next element after erase
+                constructionTypes[kept] = constructionTypes[i];
+                constructionTimeLeft[kept] = constructionTimeLeft[i];
+                constructionStatus[kept] = constructionStatus[i];
+                ++kept;
             }
         }
+        HotPathStats::addFacilities(0, constructionTypes.size() - kept);
+        constructionTypes.resize(kept);
+        constructionTimeLeft.resize(kept);
+        constructionStatus.resize(kept);
     }
     else
     { // The status is available
-        int facility_capacity = static_cast<int>(settlement.getType()) + 1 - underConstruction.size();
-        for (int i = 0; i < facility_capacity; i++)
+        int facility_capacity = capacity - constructionTypes.size();
+        // All free slots are picked in one loop specialized for the policy kind,
+        // then the new slots are filled in bulk
+        const std::vector<int>::size_type first = constructionTypes.size();
         {
-            Facility *new_facility = new Facility(
-                selectionPolicy->selectFacility(facilityOptions),
-                settlement.getName());
-            underConstruction.push_back(new_facility);
+            HotPathStats::SampledTimer selectTimer(HotPathStats::Probe::SELECT_FACILITY);
+            fillSelectionsByKind(*selectionPolicy, catalog, facility_capacity, constructionTypes);
+        }
+        HotPathStats::addFacilities(constructionTypes.size() - first, 0);
+        constructionTimeLeft.reserve(constructionTypes.size());
+        constructionStatus.reserve(constructionTypes.size());
+        for (std::vector<int>::size_type i = first; i < constructionTypes.size(); ++i)
+        {
+            constructionTimeLeft.push_back(facilityOptions[constructionTypes[i]].getCost());
+            constructionStatus.push_back(FacilityStatus::UNDER_CONSTRUCTIONS);
         }
     }
 
     // Update plan status
-    if ((int)underConstruction.size() != static_cast<int>(settlement.getType()) + 1)
+    if ((int)constructionTypes.size() != capacity)
     {
         status = PlanStatus::AVALIABLE;
     }
@@ -129,59 +152,174 @@ void Plan::step()
     }
 }
 
+// Number of steps until the next step that changes something observable: an
+// available plan acts on its very next step, a busy one only when its earliest
+// facility finishes (see the countdown in step()).
+int Plan::getStepsToNextEvent() const
+{
+    if (status == PlanStatus::AVALIABLE)
+    {
+        return 1;
+    }
+    int next = std::numeric_limits<int>::max();
+    for (int timeLeft : constructionTimeLeft)
+    {
+        next = std::min(next, timeLeft > 2 ? timeLeft - 1 : 1);
+    }
+    return next;
+}
+
+// Count down all facilities under construction by numOfSteps. Only valid for
+// steps in which none of them finishes.
+void Plan::skipSteps(int numOfSteps)
+{
+    for (int &timeLeft : constructionTimeLeft)
+    {
+        timeLeft -= numOfSteps;
+    }
+}
+
+// Everything that decides the rest of a cursor-based plan's run when it is
+// about to fill: the policy cursor and the facilities still under construction.
+vector<int> Plan::getCycleKey() const
+{
+    vector<int> key;
+    key.reserve(1 + 2 * constructionTypes.size());
+    key.push_back(selectionPolicy->getCursor());
+    for (std::vector<int>::size_type i = 0; i < constructionTypes.size(); ++i)
+    {
+        key.push_back(constructionTypes[i]);
+        key.push_back(constructionTimeLeft[i]);
+    }
+    return key;
+}
+
+// Same result as calling step() numOfSteps times, but the steps in which
+// nothing finishes are skipped in one go.
+//
+// Policies with a cursor (naive, eco, sus) make the plan periodic: once it is
+// back at a fill step with the same cycle key, the steps in between repeat
+// forever. The remaining whole repetitions are then applied at once by adding
+// the score gain and replaying the facilities completed during one period.
+void Plan::advance(int numOfSteps, const FacilityCatalog &catalog)
+{
+    std::map<vector<int>, CycleMark> marks;
+    bool detectCycles = selectionPolicy->getCursor() >= 0;
+    while (numOfSteps > 0)
+    {
+        if (detectCycles && status == PlanStatus::AVALIABLE)
+        {
+            vector<int> key = getCycleKey();
+            std::map<vector<int>, CycleMark>::const_iterator found = marks.find(key);
+            if (found != marks.end())
+            {
+                const CycleMark &mark = found->second;
+                const int period = mark.stepsLeft - numOfSteps;
+                const int cycles = numOfSteps / period;
+                const std::size_t cycleEnd = facilities.size();
+                life_quality_score += cycles * (life_quality_score - mark.life_quality_score);
+                economy_score += cycles * (economy_score - mark.economy_score);
+                environment_score += cycles * (environment_score - mark.environment_score);
+                for (int c = 0; c < cycles; ++c)
+                {
+                    for (std::size_t i = mark.facilityCount; i < cycleEnd; ++i)
+                    {
+                        facilities.push_back(facilities[i]);
+                    }
+                }
+                // Over whole periods as many facilities are started as are finished
+                HotPathStats::addFacilities(cycles * (cycleEnd - mark.facilityCount), cycles * (cycleEnd - mark.facilityCount));
+                numOfSteps -= cycles * period;
+                detectCycles = false;
+                continue;
+            }
+            if (marks.size() >= MAX_CYCLE_MARKS)
+            {
+                detectCycles = false;
+            }
+            else
+            {
+                CycleMark mark = {numOfSteps, life_quality_score, economy_score, environment_score, facilities.size()};
+                marks.insert(std::make_pair(key, mark));
+            }
+        }
+
+        int idleSteps = getStepsToNextEvent() - 1;
+        if (idleSteps >= numOfSteps)
+        {
+            skipSteps(numOfSteps);
+            return;
+        }
+        skipSteps(idleSteps);
+        step(catalog);
+        numOfSteps -= idleSteps + 1;
+    }
+}
+
 // Convert Plan object to a string representation
-const std::string Plan::toString() const
-{
-    std::ostringstream oss;
-    oss << "PlanID: " << plan_id << "\n";
-    oss << "SettlementName: " << settlement.getName() << "\n";
-    oss << "PlanStatus: " << (status == PlanStatus::AVALIABLE ? "Available" : "Busy") << "\n";
-    oss << "SelectionPolicy: " << selectionPolicy->toString() << "\n";
-    oss << "LifeQualityScore: " << life_quality_score << "\n";
-    oss << "EconomyScore: " << economy_score << "\n";
-    oss << "EnvironmentScore: " << environment_score << "\n";
-    for (Facility *fas : facilities){
-        oss << "FacilityName: " << fas->getName()<< "\n";
-        oss << "FacilityStatus: " << fas->getStatusString()<< "\n";
+const std::string Plan::toString(const vector<FacilityType> &facilityOptions) const
+{
+    std::string text;
+    appendStatus(text, facilityOptions, resumedRestore);
+    return text;
+}
+
+// Same text as toString(), appended to out. Callers that print many plans
+// reuse one buffer, so no per-plan strings or streams are created.
+void Plan::appendStatus(std::string &out, const vector<FacilityType> &facilityOptions, unsigned long long latestRestore) const
+{
+    out += "PlanID: ";
+    Auxiliary::appendInt(out, plan_id);
+    out += "\nSettlementName: ";
+    out += settlement.getName();
+    out += "\nPlanStatus: ";
+    out += getStatus(latestRestore) == PlanStatus::AVALIABLE ? "Available" : "Busy";
+    out += "\nSelectionPolicy: ";
+    out += selectionPolicy->toString();
+    out += "\nLifeQualityScore: ";
+    Auxiliary::appendInt(out, life_quality_score);
+    out += "\nEconomyScore: ";
+    Auxiliary::appendInt(out, economy_score);
+    out += "\nEnvironmentScore: ";
+    Auxiliary::appendInt(out, environment_score);
+    out += '\n';
+    for (std::size_t i = 0; i < facilities.size(); ++i)
+    {
+        out += "FacilityName: ";
+        out += facilityOptions[facilities[i]].getName();
+        out += "\nFacilityStatus: OPERATIONAL\n";
     }
-    for (Facility *fac : underConstruction)
+    for (std::vector<int>::size_type i = 0; i < constructionTypes.size(); ++i)
     {
-        oss << "FacilityName: " << fac->getName()<< "\n";
-        oss << "FacilityStatus: " << fac->getStatusString()<< "\n";
+        out += "FacilityName: ";
+        out += facilityOptions[constructionTypes[i]].getName();
+        out += constructionStatus[i] == FacilityStatus::OPERATIONAL ? "\nFacilityStatus: OPERATIONAL\n" : "\nFacilityStatus: UNDER_CONSTRUCTION\n";
     }
-    return oss.str();
 }
 Plan::Plan(const Plan &other)
     : plan_id(other.plan_id),
       settlement(other.settlement),
       selectionPolicy(other.selectionPolicy ? other.selectionPolicy->clone() : nullptr), // Deep copy selectionPolicy
       status(other.status),
-      facilities(), 
-      underConstruction(),
-      facilityOptions(other.facilityOptions),
+      resumedRestore(other.resumedRestore),
+      facilities(other.facilities), 
+      constructionTypes(other.constructionTypes),
+      constructionTimeLeft(other.constructionTimeLeft),
+      constructionStatus(other.constructionStatus),
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
       environment_score(other.environment_score) {
-    // Deep copy the facilities vector
-    for (std::vector<Facility*>::size_type i = 0; i < other.facilities.size(); ++i)
-    {
-        facilities.push_back(other.facilities.at(i)->clone());
-    }
-
-    // Deep copy the underConstruction vector
-    for (std::vector<Facility*>::size_type i = 0; i < other.underConstruction.size(); ++i)
-    {
-        underConstruction.push_back(other.underConstruction.at(i)->clone());
-    }
 }
-Plan::Plan(Plan &&other)
+Plan::Plan(Plan &&other) noexcept
     : plan_id(other.plan_id),
       settlement(other.settlement),           // Reference is copied
       selectionPolicy(other.selectionPolicy), // Pointer is moved
       status(other.status),
-      facilities(std::move(other.facilities)),               // Vector is moved
-      underConstruction(std::move(other.underConstruction)), // Vector is moved
-      facilityOptions(other.facilityOptions),                // Reference is copied
+      resumedRestore(other.resumedRestore),
+      facilities(std::move(other.facilities)),               // History is moved
+      constructionTypes(std::move(other.constructionTypes)),       // Vectors are moved
+      constructionTimeLeft(std::move(other.constructionTimeLeft)),
+      constructionStatus(std::move(other.constructionStatus)),
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
       environment_score(other.environment_score)
@@ -192,25 +330,56 @@ Plan::Plan(Plan &&other)
 Plan::~Plan()
 {
     delete selectionPolicy;
+}
+const string &Plan::getSettlement() const
+{
+    return settlement.getName();
+}
 
-    for (Facility *facility : facilities)
-    {
-        delete facility;
-    }
+SettlementType Plan::getSettlementType() const
+{
+    return settlement.getType();
+}
+
+int Plan::getFacilityCount() const
+{
+    return facilities.size();
+}
 
-    for (Facility *facilityUnderConstructions : underConstruction)
+Facility Plan::getFacility(int index, const vector<FacilityType> &facilityOptions) const
+{
+    if (index < getFacilityCount())
     {
-        delete facilityUnderConstructions;
+        // a finished facility's countdown always stopped at 2, or at its cost if lower
+        const int type = facilities[index];
+        return Facility(facilityOptions, type, settlement, FacilityStatus::OPERATIONAL, std::min(facilityOptions[type].getCost(), 2));
     }
+    index -= getFacilityCount();
+    return Facility(facilityOptions, constructionTypes[index], settlement, constructionStatus[index], constructionTimeLeft[index]);
 }
-const string &Plan::getSettlement() const
+
+// Approximate; the policy and construction lists belong to this copy alone,
+// the facility history is shared chunk by chunk
+void Plan::countMemory(MemoryUsage &usage) const
 {
-    return settlement.getName();
+    usage.visit(this, sizeof(Plan) + sizeof(*selectionPolicy) + constructionTypes.capacity() * sizeof(int) +
+                          constructionTimeLeft.capacity() * sizeof(int) +
+                          constructionStatus.capacity() * sizeof(FacilityStatus));
+    facilities.countMemory(usage);
 }
 
-const vector<Facility *> &Plan::getFacilities() const
+PlanStatus Plan::getStatus(unsigned long long latestRestore) const
 {
-    return facilities;
+    return resumedRestore < latestRestore ? PlanStatus::AVALIABLE : status;
+}
+
+void Plan::resume(unsigned long long latestRestore)
+{
+    if (resumedRestore < latestRestore)
+    {
+        status = PlanStatus::AVALIABLE;
+        resumedRestore = latestRestore;
+    }
 }
 
 int Plan::getPlanId() const
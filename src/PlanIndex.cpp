@@ -0,0 +1,302 @@
+#include "PlanIndex.h"
+#include "Settlement.h"
+#include "SelectionPolicy.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    const int SCORE_COUNT = 4;
+    const char *SCORE_FIELDS[] = {"life", "economy", "environment", "total"};
+    const char *SETTLEMENT_TYPES[] = {"village", "city", "metropolis"};
+    const char *POLICIES[] = {"naiv", "bal", "eco", "sus"}; // by PolicyKind, as SelectionPolicy::toString
+    const char *STATUSES[] = {"available", "busy"};
+
+    int findName(const char *const *names, int count, const string &value)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (value == names[i])
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    long long getScore(const Plan &plan, int score)
+    {
+        switch (score)
+        {
+        case 0:
+            return plan.getlifeQualityScore();
+        case 1:
+            return plan.getEconomyScore();
+        case 2:
+            return plan.getEnvironmentScore();
+        default:
+            return static_cast<long long>(plan.getlifeQualityScore()) + plan.getEconomyScore() + plan.getEnvironmentScore();
+        }
+    }
+}
+
+PlanFilter::PlanFilter() : settlementName(), settlementType(-1), policy(-1), status(-1), contradictory(false)
+{
+    for (int i = 0; i < SCORE_COUNT; i++)
+    {
+        minScore[i] = std::numeric_limits<long long>::min();
+        maxScore[i] = std::numeric_limits<long long>::max();
+    }
+}
+
+bool PlanFilter::addPredicate(const string &predicate, string &errorMsg)
+{
+    string::size_type opBegin = predicate.find_first_of("<>=");
+    if (opBegin == string::npos || opBegin == 0)
+    {
+        errorMsg = "invalid predicate " + predicate;
+        return false;
+    }
+    string::size_type opEnd = opBegin + 1;
+    if (opEnd < predicate.size() && predicate[opEnd] == '=' && predicate[opBegin] != '=')
+    {
+        opEnd++;
+    }
+    const string field = predicate.substr(0, opBegin);
+    const string op = predicate.substr(opBegin, opEnd - opBegin);
+    const string value = predicate.substr(opEnd);
+
+    int score = findName(SCORE_FIELDS, SCORE_COUNT, field);
+    if (score >= 0)
+    {
+        long long number;
+        try
+        {
+            std::size_t used;
+            number = std::stoll(value, &used);
+            if (used != value.size())
+            {
+                throw std::invalid_argument(value);
+            }
+        }
+        catch (const std::logic_error &)
+        {
+            errorMsg = "invalid number in " + predicate;
+            return false;
+        }
+        // Narrow the inclusive range [minScore, maxScore]
+        if ((op == "=" || op == ">=") && number > minScore[score])
+            minScore[score] = number;
+        if ((op == "=" || op == "<=") && number < maxScore[score])
+            maxScore[score] = number;
+        if (op == ">" && number != std::numeric_limits<long long>::max() && number + 1 > minScore[score])
+            minScore[score] = number + 1;
+        if (op == "<" && number != std::numeric_limits<long long>::min() && number - 1 < maxScore[score])
+            maxScore[score] = number - 1;
+        if ((op == ">" && number == std::numeric_limits<long long>::max()) ||
+            (op == "<" && number == std::numeric_limits<long long>::min()) || minScore[score] > maxScore[score])
+            contradictory = true;
+        return true;
+    }
+
+    if (op != "=")
+    {
+        errorMsg = "only = applies to " + field;
+        return false;
+    }
+    int *category = nullptr;
+    int found = -1;
+    if (field == "settlement")
+    {
+        if (!settlementName.empty() && settlementName != value)
+        {
+            contradictory = true;
+        }
+        settlementName = value;
+        return true;
+    }
+    else if (field == "type")
+    {
+        category = &settlementType;
+        found = findName(SETTLEMENT_TYPES, 3, value);
+    }
+    else if (field == "policy")
+    {
+        category = &policy;
+        found = findName(POLICIES, 4, value);
+    }
+    else if (field == "status")
+    {
+        category = &status;
+        found = findName(STATUSES, 2, value);
+    }
+    else
+    {
+        errorMsg = "no field like " + field;
+        return false;
+    }
+    if (found < 0)
+    {
+        errorMsg = "no " + field + " like " + value;
+        return false;
+    }
+    if (*category >= 0 && *category != found)
+    {
+        contradictory = true;
+    }
+    *category = found;
+    return true;
+}
+
+PlanIndex::Partition::Partition(int valueCount) : members(valueCount), valueOf(), position() {}
+
+void PlanIndex::Partition::add(int planId, int value)
+{
+    valueOf.push_back(value);
+    position.push_back(members[value].size());
+    members[value].push_back(planId);
+}
+
+void PlanIndex::Partition::move(int planId, int value)
+{
+    int old = valueOf[planId];
+    if (old == value)
+    {
+        return;
+    }
+    // Swap-remove from the old list, append to the new one
+    vector<int> &from = members[old];
+    int last = from.back();
+    from[position[planId]] = last;
+    position[last] = position[planId];
+    from.pop_back();
+    valueOf[planId] = value;
+    position[planId] = members[value].size();
+    members[value].push_back(planId);
+}
+
+PlanIndex::PlanIndex()
+    : built(false), indexedPlans(0), bySettlement(), bySettlementType(3), byPolicy(4), byStatus(2),
+      changedPlans(), isChanged() {}
+
+bool PlanIndex::isBuilt() const
+{
+    return built;
+}
+
+void PlanIndex::clear()
+{
+    *this = PlanIndex();
+}
+
+void PlanIndex::markChanged(const vector<int> &planIds)
+{
+    if (!built)
+    {
+        return; // the next build reads every plan anyway
+    }
+    for (int planId : planIds)
+    {
+        if (static_cast<std::size_t>(planId) < indexedPlans && !isChanged[planId])
+        {
+            isChanged[planId] = 1;
+            changedPlans.push_back(planId);
+        }
+    }
+}
+
+// Takes in the changes reported since the last query. Plans are never removed
+// and ids are handed out in order, so plans past indexedPlans are the new ones.
+void PlanIndex::refresh(const CowVector<Plan> &plans, unsigned long long latestRestore)
+{
+    built = true;
+    for (int planId : changedPlans)
+    {
+        const Plan &plan = plans[planId];
+        byPolicy.move(planId, static_cast<int>(plan.getSelectionPolicy()->getKind()));
+        byStatus.move(planId, static_cast<int>(plan.getStatus(latestRestore)));
+        isChanged[planId] = 0;
+    }
+    changedPlans.clear();
+    for (; indexedPlans < plans.size(); indexedPlans++)
+    {
+        const Plan &plan = plans[indexedPlans];
+        int planId = static_cast<int>(indexedPlans);
+        bySettlement[plan.getSettlement()].push_back(planId);
+        bySettlementType.add(planId, static_cast<int>(plan.getSettlementType()));
+        byPolicy.add(planId, static_cast<int>(plan.getSelectionPolicy()->getKind()));
+        byStatus.add(planId, static_cast<int>(plan.getStatus(latestRestore)));
+        isChanged.push_back(0);
+    }
+}
+
+bool PlanIndex::matches(const Plan &plan, int planId, const PlanFilter &filter) const
+{
+    if ((filter.settlementType != -1 && bySettlementType.valueOf[planId] != filter.settlementType) ||
+        (filter.policy != -1 && byPolicy.valueOf[planId] != filter.policy) ||
+        (filter.status != -1 && byStatus.valueOf[planId] != filter.status) ||
+        (!filter.settlementName.empty() && plan.getSettlement() != filter.settlementName))
+    {
+        return false;
+    }
+    for (int i = 0; i < SCORE_COUNT; i++)
+    {
+        long long score = getScore(plan, i);
+        if (score < filter.minScore[i] || score > filter.maxScore[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PlanIndex::select(const CowVector<Plan> &plans, const PlanFilter &filter, unsigned long long latestRestore, vector<int> &planIds)
+{
+    refresh(plans, latestRestore);
+    if (filter.contradictory)
+    {
+        return;
+    }
+    // Only scan the shortest list of plans that a categorical predicate allows
+    const vector<int> *candidates = nullptr;
+    std::unordered_map<string, vector<int>>::const_iterator settlement = bySettlement.end();
+    if (!filter.settlementName.empty())
+    {
+        settlement = bySettlement.find(filter.settlementName);
+        if (settlement == bySettlement.end())
+        {
+            return;
+        }
+        candidates = &settlement->second;
+    }
+    const Partition *partitions[] = {&bySettlementType, &byPolicy, &byStatus};
+    const int values[] = {filter.settlementType, filter.policy, filter.status};
+    for (int i = 0; i < 3; i++)
+    {
+        if (values[i] >= 0 && (candidates == nullptr || partitions[i]->members[values[i]].size() < candidates->size()))
+        {
+            candidates = &partitions[i]->members[values[i]];
+        }
+    }
+
+    if (candidates == nullptr)
+    {
+        for (std::size_t i = 0; i < plans.size(); i++)
+        {
+            if (matches(plans[i], static_cast<int>(i), filter))
+            {
+                planIds.push_back(static_cast<int>(i));
+            }
+        }
+        return;
+    }
+    for (int planId : *candidates)
+    {
+        if (matches(plans[planId], planId, filter))
+        {
+            planIds.push_back(planId);
+        }
+    }
+    std::sort(planIds.begin(), planIds.end()); // policy and status lists are unordered
+}
@@ -1,16 +1,40 @@
 #include <vector>
 #include "Facility.h"
 #include "SelectionPolicy.h"
+#include "SlabAllocator.h"
 #include <algorithm> // For std::min and std::max
 #include <stdexcept>
+#include <limits>
 
 using std::vector;
+
+namespace
+{
+    // Balanced plans revisit a handful of offset pairs; this only bounds odd cases
+    const std::size_t MAX_BALANCED_CACHE = 4096;
+}
+
+// Policies are cloned with every plan copy, so they come from the slab pool
+void *SelectionPolicy::operator new(std::size_t size)
+{
+    return SlabAllocator::allocate(size);
+}
+void SelectionPolicy::operator delete(void *pointer, std::size_t size)
+{
+    SlabAllocator::deallocate(pointer, size);
+}
+
+SelectionPolicy::SelectionPolicy(PolicyKind kind) : kind(kind) {}
+
 // NaiveSelection Implementation
-NaiveSelection::NaiveSelection() : lastSelectedIndex(0) {};
-const FacilityType &NaiveSelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+NaiveSelection::NaiveSelection() : SelectionPolicy(PolicyKind::NAIVE), lastSelectedIndex(0) {};
+const FacilityType &NaiveSelection::selectFacility(const FacilityCatalog &catalog)
+{
+    return catalog.getTypes()[selectIndex(catalog)];
+}
+void NaiveSelection::selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected)
 {
-    lastSelectedIndex = (lastSelectedIndex + 1) % facilitiesOptions.size(); // so it will return to the start of the vector (we dont want unexpected behavior)
-    return facilitiesOptions[lastSelectedIndex];
+    fillSelections(*this, catalog, count, selected);
 }
 const string NaiveSelection::toString() const
 {
@@ -21,17 +45,70 @@ NaiveSelection *NaiveSelection::clone() const
 {
     return new NaiveSelection(*this);
 }
+int NaiveSelection::getCursor() const
+{
+    return lastSelectedIndex;
+}
 
 // BalancedSelection Implementation
 BalancedSelection::BalancedSelection(int lifeQualityScore, int economyScore, int environmentScore)
-    : LifeQualityScore(lifeQualityScore), EconomyScore(economyScore), EnvironmentScore(environmentScore) {}
-const FacilityType &BalancedSelection::selectFacility(const std::vector<FacilityType> &facilitiesOptions)
+    : SelectionPolicy(PolicyKind::BALANCED),
+      LifeQualityScore(lifeQualityScore), EconomyScore(economyScore), EnvironmentScore(environmentScore),
+      decisionCache(), cacheVersion(0) {}
+// Copies start with an empty cache: plans are copied for every backup, and the
+// cache is cheap to rebuild
+BalancedSelection::BalancedSelection(const BalancedSelection &other)
+    : SelectionPolicy(other), LifeQualityScore(other.LifeQualityScore), EconomyScore(other.EconomyScore),
+      EnvironmentScore(other.EnvironmentScore), decisionCache(), cacheVersion(0) {}
+const FacilityType &BalancedSelection::selectFacility(const FacilityCatalog &catalog)
+{
+    return catalog.getTypes()[selectIndex(catalog)];
+}
+void BalancedSelection::selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected)
+{
+    fillSelections(*this, catalog, count, selected);
+}
+int BalancedSelection::selectIndex(const FacilityCatalog &catalog)
 {
+    if (cacheVersion != catalog.getVersion() || decisionCache.size() >= MAX_BALANCED_CACHE)
+    {
+        decisionCache.clear();
+        cacheVersion = catalog.getVersion();
+    }
+
+    // Adding the same amount to all three scores doesn't change max - min, so
+    // only the offsets from the environment score matter
+    unsigned long long key = (static_cast<unsigned long long>(static_cast<unsigned int>(LifeQualityScore - EnvironmentScore)) << 32) |
+                             static_cast<unsigned int>(EconomyScore - EnvironmentScore);
+    std::unordered_map<unsigned long long, int>::const_iterator cached = decisionCache.find(key);
+    int chosen;
+    if (cached != decisionCache.end())
+    {
+        chosen = cached->second;
+    }
+    else
+    {
+        chosen = chooseFacility(catalog);
+        decisionCache.insert(std::make_pair(key, chosen));
+    }
+
+    const FacilityType &bestFacility = catalog.getTypes()[chosen];
+    // Update the fields with the scores of the best facility
+    LifeQualityScore += bestFacility.getLifeQualityScore();
+    EconomyScore += bestFacility.getEconomyScore();
+    EnvironmentScore += bestFacility.getEnvironmentScore();
+    return chosen;
+}
+// Index of the first facility that leaves the scores closest together
+int BalancedSelection::chooseFacility(const FacilityCatalog &catalog) const
+{
+    const vector<FacilityType> &facilitiesOptions = catalog.getTypes();
     int minDifference = std::numeric_limits<int>::max(); // Initialize to a very large number
-    const FacilityType *bestFacility = nullptr;
+    int bestFacility = -1;
 
-    for (const FacilityType &facility : facilitiesOptions)
+    for (std::size_t i = 0; i < catalog.size(); i++)
     {
+        const FacilityType &facility = facilitiesOptions[i];
         // Calculate temporary scores for the current facility
         int tempLifeQualityScore = LifeQualityScore + facility.getLifeQualityScore();
         int tempEconomyScore = EconomyScore + facility.getEconomyScore();
@@ -46,20 +123,11 @@ const FacilityType &BalancedSelection::selectFacility(const std::vector<Facility
         if (diff < minDifference)
         {
             minDifference = diff;
-            bestFacility = &facility;
+            bestFacility = i;
         }
     }
 
-    // Ensure a valid facility was found
-    if (bestFacility)
-    {
-        // Update the fields with the scores of the best facility
-        LifeQualityScore += bestFacility->getLifeQualityScore();
-        EconomyScore += bestFacility->getEconomyScore();
-        EnvironmentScore += bestFacility->getEnvironmentScore();
-    }
-
-    return *bestFacility; // Return the best facility
+    return bestFacility;
 }
 const string BalancedSelection::toString() const
 {
@@ -69,79 +137,53 @@ BalancedSelection *BalancedSelection::clone() const
 {
     return new BalancedSelection(*this);
 }
+int BalancedSelection::getCursor() const
+{
+    return -1; // choices depend on the running scores
+}
 
 // Econemy selection:
-EconomySelection::EconomySelection() : lastSelectedIndex(0) {};
-const FacilityType &EconomySelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+EconomySelection::EconomySelection() : SelectionPolicy(PolicyKind::ECONOMY), lastSelectedIndex(0) {};
+const FacilityType &EconomySelection::selectFacility(const FacilityCatalog &catalog)
 {
-    if (facilitiesOptions.empty())
-    {
-        throw std::runtime_error("No facilities available to select from.");
-    }
-
-    for (std::vector<FacilityType>::size_type i = lastSelectedIndex; i < facilitiesOptions.size(); i++)
-    {
-        if (facilitiesOptions[i].getCategory() == FacilityCategory::ECONOMY)
-        {
-            lastSelectedIndex = (i + 1) % facilitiesOptions.size(); // Update to the next index
-            return facilitiesOptions[i];
-        }
-    }
-
-    for (int i = 0; i < lastSelectedIndex; i++)
-    {
-        if (facilitiesOptions[i].getCategory() == FacilityCategory::ECONOMY)
-        {
-            lastSelectedIndex = (i + 1) % facilitiesOptions.size(); // Update to the next index
-            return facilitiesOptions[i];
-        }
-    }
-
-    throw std::runtime_error("No facility with the correct category found.");
+    return catalog.getTypes()[selectIndex(catalog)];
+}
+void EconomySelection::selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected)
+{
+    fillSelections(*this, catalog, count, selected);
 }
 
 EconomySelection *EconomySelection::clone() const
 {
     return new EconomySelection(*this);
 }
+int EconomySelection::getCursor() const
+{
+    return lastSelectedIndex;
+}
 const string EconomySelection::toString() const
 {
     return "eco";
 }
 // Sustainable selection:
-SustainabilitySelection::SustainabilitySelection() : lastSelectedIndex(0) {};
-const FacilityType &SustainabilitySelection::selectFacility(const vector<FacilityType> &facilitiesOptions)
+SustainabilitySelection::SustainabilitySelection() : SelectionPolicy(PolicyKind::SUSTAINABILITY), lastSelectedIndex(0) {};
+const FacilityType &SustainabilitySelection::selectFacility(const FacilityCatalog &catalog)
 {
-    if (facilitiesOptions.empty())
-    {
-        throw std::runtime_error("No facilities available to select from.");
-    }
-
-    for (std::vector<FacilityType>::size_type i = lastSelectedIndex; i < facilitiesOptions.size(); i++)
-    {
-        if (facilitiesOptions[i].getCategory() == FacilityCategory::ENVIRONMENT)
-        {
-            lastSelectedIndex = (i + 1) % facilitiesOptions.size(); // Update to the next index
-            return facilitiesOptions[i];
-        }
-    }
-
-    for (int i = 0; i < lastSelectedIndex; i++)
-    {
-        if (facilitiesOptions[i].getCategory() == FacilityCategory::ENVIRONMENT)
-        {
-            lastSelectedIndex = (i + 1) % facilitiesOptions.size(); // Update to the next index
-            return facilitiesOptions[i];
-        }
-    }
-
-    throw std::runtime_error("No facility with the correct category found.");
+    return catalog.getTypes()[selectIndex(catalog)];
+}
+void SustainabilitySelection::selectFacilities(const FacilityCatalog &catalog, int count, vector<int> &selected)
+{
+    fillSelections(*this, catalog, count, selected);
 }
 
 SustainabilitySelection *SustainabilitySelection::clone() const
 {
     return new SustainabilitySelection(*this);
 }
+int SustainabilitySelection::getCursor() const
+{
+    return lastSelectedIndex;
+}
 const string SustainabilitySelection::toString() const
 {
     return "sus";
@@ -1,4 +1,5 @@
 #include "Settlement.h" 
+#include "MemoryUsage.h"
 #include <iostream>
 #include <sstream> 
 
@@ -37,3 +38,8 @@ const string Settlement::toString() const
     }
     return "Settlement Name: " + name + "\n" + "Settlement Type: " + typeStr + "\n";
 }
+
+void Settlement::countMemory(MemoryUsage &usage) const
+{
+    usage.visit(this, sizeof(Settlement) + name.capacity());
+}
@@ -1,4 +1,3 @@
-#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -11,87 +10,48 @@
 #include "SelectionPolicy.h"
 #include "Action.h"
 #include "Plan.h"
+#include "SnapshotStore.h"
+#include "MappedFile.h"
+#include "HotPathStats.h"
+#include "MemoryUsage.h"
+#include "SlabAllocator.h"
+#include <cstring>
+#include <chrono>
+#include <mutex>
 #include <sstream>
 using namespace std;
-Simulation *backupSim = nullptr;
+SnapshotStore *snapshotStore = nullptr;
+
+namespace
+{
+    // Restores of every simulation, so that restore numbers only grow
+    unsigned long long restoreCount = 0;
+}
 
 // Constructor
-Simulation::Simulation(const std::string &configFilePath)
-    : isRunning(false), planCounter(0), 
-    actionsLog(), plans(), settlements(), facilitiesOptions()
+Simulation::Simulation(const std::string &configFilePath, WorkerPool *workerPool)
+    : isRunning(false), planCounter(0), latestRestore(0),
+    actionsLog(), plans(), settlements(),
+    settlementIndex(),
+    facilityCatalog(std::make_shared<FacilityCatalog>()), workerPool(workerPool), leaderboard(), planIndex()
 {
     parseConfigFile(configFilePath);
 }
 
-// Copy constructor
+// Copy constructor: shares all state with other; it is duplicated piece by piece on write
 Simulation::Simulation(const Simulation &other)
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
-      actionsLog(),
-      plans(),
-      settlements(),
-      facilitiesOptions(other.facilitiesOptions)
+      latestRestore(other.latestRestore),
+      actionsLog(other.actionsLog),
+      plans(other.plans),
+      settlements(other.settlements),
+      settlementIndex(other.settlementIndex),
+      facilityCatalog(other.facilityCatalog),
+      workerPool(other.workerPool),
+      leaderboard(),
+      planIndex()
 {
-    // Deep copy actionsLog
-    for (auto *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    for (auto *settlement : other.settlements)
-    {
-        settlements.push_back(new Settlement(*settlement));
-    }
-
-    // Deep copy plans
-    for (const auto &plan : other.plans)
-    {
-        const std::string &settlementName = plan.getSettlement();
-        Settlement *newSettlement = nullptr;
-
-        // Find corresponding settlement
-        for (Settlement *copiedSettlement : settlements)
-        {
-            if (copiedSettlement->getName() == settlementName)
-            {
-                newSettlement = copiedSettlement;
-                break;
-            }
-        }
-
-        if (!newSettlement)
-        {
-            throw std::runtime_error("Settlement not found for Plan during copy constructor: " + settlementName);
-        }
-
-        // Deep copy facilities
-        std::vector<Facility *> copiedFacilities;
-        for (Facility *facility : plan.getFacilities())
-        {
-            copiedFacilities.push_back(facility->clone());
-        }
-
-        // Deep copy underConstruction
-        std::vector<Facility *> copiedUnderConstruction;
-        for (Facility *facility : plan.getUnderConstruction())
-        {
-            copiedUnderConstruction.push_back(facility->clone());
-        }
-
-        // Reconstruct the Plan
-        plans.emplace_back(
-            plan.getPlanId(),
-            *newSettlement, // Deep-copied settlement
-            plan.getSelectionPolicy() ? plan.getSelectionPolicy()->clone() : nullptr,
-            facilitiesOptions,
-            plan.getlifeQualityScore(),
-            plan.getEconomyScore(),
-            plan.getEnvironmentScore(),
-            std::move(copiedFacilities),       // Transfer ownership
-            std::move(copiedUnderConstruction) // Transfer ownership
-        );
-    }
 }
 
 
@@ -103,81 +63,16 @@ Simulation &Simulation::operator=(const Simulation &other)
         return *this; // Prevent self-assignment
     }
 
-    // Cleanup current resources
-    for (BaseAction *action : actionsLog)
-    {
-        delete action;
-    }
-    actionsLog.clear();
-
-    for (Settlement *settlement : settlements)
-    {
-        delete settlement;
-    }
-    settlements.clear();
-
-    plans.clear();
-    facilitiesOptions.clear();
-
-    // Copy basic members
     isRunning = other.isRunning;
     planCounter = other.planCounter;
-    for (const FacilityType &facility : other.facilitiesOptions)
-    {
-        facilitiesOptions.push_back(facility); // Uses copy constructor
-    }
-    // Deep copy actionsLog
-    for (BaseAction *action : other.actionsLog)
-    {
-        actionsLog.push_back(action->clone());
-    }
-
-    // Deep copy settlements
-    for (Settlement *settlement : other.settlements)
-    {
-        settlements.push_back(new Settlement(*settlement));
-    }
-
-    // Deep copy plans
-    for (const auto &plan : other.plans)
-    {
-        Settlement *newSettlement = nullptr;
-        for (Settlement *copiedSettlement : settlements)
-        {
-            if (copiedSettlement->getName() == plan.getSettlement())
-            {
-                newSettlement = copiedSettlement;
-                break;
-            }
-        }
-        if (!newSettlement)
-        {
-            throw std::runtime_error("Settlement not found during copy assignment.");
-        }
-
-        std::vector<Facility *> copiedFacilities;
-        for (Facility *facility : plan.getFacilities())
-        {
-            copiedFacilities.push_back(facility->clone());
-        }
-
-        std::vector<Facility *> copiedUnderConstruction;
-        for (Facility *facility : plan.getUnderConstruction())
-        {
-            copiedUnderConstruction.push_back(facility->clone());
-        }
-
-        plans.emplace_back(
-            plan.getPlanId(),
-            *newSettlement,
-            plan.getSelectionPolicy() ? plan.getSelectionPolicy()->clone() : nullptr,
-            facilitiesOptions,
-            plan.getlifeQualityScore(),
-            plan.getEconomyScore(),
-            plan.getEnvironmentScore(),
-            std::move(copiedFacilities),
-            std::move(copiedUnderConstruction));
-    }
+    latestRestore = other.latestRestore;
+    actionsLog = other.actionsLog;
+    plans = other.plans;
+    settlements = other.settlements;
+    settlementIndex = other.settlementIndex;
+    facilityCatalog = other.facilityCatalog;
+    leaderboard.clear();
+    planIndex.clear();
 
     return *this;
 }
@@ -187,10 +82,15 @@ Simulation &Simulation::operator=(const Simulation &other)
 Simulation::Simulation(Simulation &&other) noexcept
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
+      latestRestore(other.latestRestore),
       actionsLog(std::move(other.actionsLog)),
       plans(std::move(other.plans)),
       settlements(std::move(other.settlements)),
-      facilitiesOptions(std::move(other.facilitiesOptions))
+      settlementIndex(std::move(other.settlementIndex)),
+      facilityCatalog(std::move(other.facilityCatalog)),
+      workerPool(other.workerPool),
+      leaderboard(std::move(other.leaderboard)),
+      planIndex(std::move(other.planIndex))
 {
 
     other.isRunning = false;
@@ -205,26 +105,18 @@ Simulation &Simulation::operator=(Simulation &&other) noexcept
         return *this;
     }
 
-    // Cleanup current resources
-    for (auto *action : actionsLog)
-    {
-        delete action;
-    }
-    for (auto *settlement : settlements)
-    {
-        delete settlement;
-    }
-
-    actionsLog.clear();
-    settlements.clear();
-
     // Move data
     isRunning = other.isRunning;
     planCounter = other.planCounter;
+    latestRestore = other.latestRestore;
     actionsLog = std::move(other.actionsLog);
     plans = std::move(other.plans);
     settlements = std::move(other.settlements);
-    facilitiesOptions = std::move(other.facilitiesOptions);
+    settlementIndex = std::move(other.settlementIndex);
+    facilityCatalog = std::move(other.facilityCatalog);
+    workerPool = other.workerPool;
+    leaderboard = std::move(other.leaderboard);
+    planIndex = std::move(other.planIndex);
 
     // Nullify the moved-from object's state
     other.isRunning = false;
@@ -233,157 +125,269 @@ Simulation &Simulation::operator=(Simulation &&other) noexcept
     return *this;
 }
 
-// Destructor
+// Destructor: plans, settlements and logged actions are released with the last simulation sharing them
 Simulation::~Simulation()
 {
-    for (BaseAction *action : actionsLog)
-    {
-        if (action)
-            delete action;
-        action = nullptr;
-    }
-    for (Settlement *settlement : settlements)
-    {
-        if (settlement)
-            delete settlement;
-        settlement = nullptr;
-    }
-    settlements.clear(); // Clear the vector
-    plans.clear();
-    facilitiesOptions.clear(); 
 }
 
-// Function to parse configuration file
-void Simulation::parseConfigFile(const std::string &configFilePath)
+namespace
 {
-    std::ifstream configFile(configFilePath);
-    if (!configFile.is_open())
+    // Config lines have at most 7 words; one more is kept so longer lines are still counted
+    const std::size_t MAX_CONFIG_ARGUMENTS = 8;
+    // Files smaller than this are parsed as one shard
+    const std::size_t MIN_SHARD_BYTES = 1 << 20;
+
+    // A plan line, or a message to report, kept in file order until the merge
+    struct ConfigRecord
     {
-        throw std::runtime_error("Failed to open configuration file.");
-    }
+        bool isPlan;
+        std::size_t settlementsBefore; // settlements defined earlier in the same shard
+        string text;                   // plan: settlement name; otherwise: the message
+        string policy;
+    };
 
-    std::string line;
-    while (std::getline(configFile, line))
+    // What one slice of the config file defines, parsed independently of the others
+    struct ConfigShard
     {
-        // Trim leading/trailing whitespaces
-        line.erase(0, line.find_first_not_of(" \t\n\r"));
-        line.erase(line.find_last_not_of(" \t\n\r") + 1);
+        ConfigShard() : begin(nullptr), end(nullptr), settlements(), facilities(), records() {}
+        ConfigShard(const ConfigShard &other) = delete;
+        ConfigShard &operator=(const ConfigShard &other) = delete;
+        const char *begin;
+        const char *end;
+        vector<Settlement *> settlements;
+        vector<FacilityType> facilities;
+        vector<ConfigRecord> records;
+    };
 
-        // Skip empty lines or comments
-        if (line.empty() || line[0] == '#')
-        {
-            continue;
-        }
+    const char *findLineEnd(const char *line, const char *end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        return newline != nullptr ? newline : end;
+    }
 
-        // Parse the line into arguments
-        std::vector<std::string> arguments = Auxiliary::parseArguments(line);
-        if (arguments.empty())
+    const char *skipBlanks(const char *position, const char *end)
+    {
+        while (position != end && (*position == ' ' || *position == '\t' || *position == '\r'))
         {
-            continue;
+            position++;
         }
+        return position;
+    }
 
-        // Process based on the first argument
-        const std::string &command = arguments[0];
-        if (command == "settlement")
+    void addMessage(ConfigShard &shard, const string &message)
+    {
+        ConfigRecord record = {false, 0, message, string()};
+        shard.records.push_back(record);
+    }
+
+    // Handle settlement command
+    void parseSettlement(ConfigShard &shard, const Auxiliary::Token *arguments, std::size_t count)
+    {
+        if (count == 3)
         {
-            handleSettlementCommand(arguments);
+            try
+            {
+                SettlementType type = static_cast<SettlementType>(Auxiliary::parseInt(arguments[2]));
+                shard.settlements.push_back(new Settlement(arguments[1].toString(), type));
+            }
+            catch (const std::exception &e)
+            {
+                addMessage(shard, "Error parsing settlement type for " + arguments[1].toString() + ": " + e.what());
+            }
         }
-        else if (command == "facility")
+        else
         {
-            handleFacilityCommand(arguments);
+            addMessage(shard, "Invalid number of arguments for settlement command");
         }
-        else if (command == "plan")
+    }
+
+    // Handle facility command
+    void parseFacility(ConfigShard &shard, const Auxiliary::Token *arguments, std::size_t count)
+    {
+        if (count == 7)
         {
-            handlePlanCommand(arguments);
+            try
+            {
+                FacilityType facility(
+                    arguments[1].toString(),
+                    static_cast<FacilityCategory>(Auxiliary::parseInt(arguments[2])),
+                    Auxiliary::parseInt(arguments[3]),
+                    Auxiliary::parseInt(arguments[4]),
+                    Auxiliary::parseInt(arguments[5]),
+                    Auxiliary::parseInt(arguments[6]));
+                shard.facilities.push_back(facility);
+            }
+            catch (const std::exception &e)
+            {
+                addMessage(shard, "Error parsing facility for " + arguments[1].toString() + ": " + e.what());
+            }
         }
         else
         {
-            std::cerr << "Unknown command: " << command << std::endl;
+            addMessage(shard, "Invalid number of arguments for facility command");
         }
     }
-    planCounter = plans.size();
-    configFile.close();
-}
 
-// Handle settlement command
-void Simulation::handleSettlementCommand(const std::vector<std::string> &arguments)
-{
-    if (arguments.size() == 3)
+    // Handle plan command. The settlement is looked up after the merge, when
+    // every settlement defined before this line is known.
+    void parsePlan(ConfigShard &shard, const Auxiliary::Token *arguments, std::size_t count)
     {
-        try
+        if (count == 3)
         {
-            SettlementType type = static_cast<SettlementType>(std::stoi(arguments[2]));
-            settlements.push_back(new Settlement(arguments[1], type));
+            ConfigRecord record = {true, shard.settlements.size(), arguments[1].toString(), arguments[2].toString()};
+            shard.records.push_back(record);
         }
-        catch (const std::exception &e)
+        else
         {
-            std::cerr << "Error parsing settlement type for " << arguments[1] << ": " << e.what() << std::endl;
+            addMessage(shard, "Invalid number of arguments for plan command");
         }
     }
-    else
+
+    void parseShard(ConfigShard &shard)
     {
-        std::cerr << "Invalid number of arguments for settlement command" << std::endl;
+        Auxiliary::Token arguments[MAX_CONFIG_ARGUMENTS];
+        for (const char *line = shard.begin; line != shard.end;)
+        {
+            const char *lineEnd = findLineEnd(line, shard.end);
+            const char *first = skipBlanks(line, lineEnd);
+            line = lineEnd == shard.end ? shard.end : lineEnd + 1;
+
+            // Skip empty lines or comments
+            if (first == lineEnd || *first == '#')
+            {
+                continue;
+            }
+
+            // Parse the line into arguments
+            std::size_t count = Auxiliary::splitArguments(first, lineEnd, arguments, MAX_CONFIG_ARGUMENTS);
+            if (count == 0)
+            {
+                continue;
+            }
+
+            // Process based on the first argument
+            const Auxiliary::Token &command = arguments[0];
+            if (command.equals("settlement"))
+            {
+                parseSettlement(shard, arguments, count);
+            }
+            else if (command.equals("facility"))
+            {
+                parseFacility(shard, arguments, count);
+            }
+            else if (command.equals("plan"))
+            {
+                parsePlan(shard, arguments, count);
+            }
+            else
+            {
+                addMessage(shard, "Unknown command: " + command.toString());
+            }
+        }
     }
 }
 
-// Handle facility command
-void Simulation::handleFacilityCommand(const std::vector<std::string> &arguments)
+// Function to parse configuration file. The mapped file is cut into shards at
+// line boundaries, which the worker pool parses in parallel. The shards are
+// then merged in file order, so settlements, the catalog, plan ids and error
+// messages come out exactly as if the file had been read line by line.
+void Simulation::parseConfigFile(const std::string &configFilePath)
 {
-    if (arguments.size() == 7)
+    MappedFile configFile(configFilePath);
+    if (!configFile.isOpen())
     {
-        try
-        {
-            FacilityType facility(
-                arguments[1],
-                static_cast<FacilityCategory>(std::stoi(arguments[2])),
-                std::stoi(arguments[3]),
-                std::stoi(arguments[4]),
-                std::stoi(arguments[5]),
-                std::stoi(arguments[6]));
-            facilitiesOptions.push_back(facility);
-        }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Error parsing facility for " << arguments[1] << ": " << e.what() << std::endl;
-        }
+        throw std::runtime_error("Failed to open configuration file.");
     }
-    else
+    const char *data = configFile.getData();
+    const char *end = data + configFile.getSize();
+
+    std::size_t shardCount = 1;
+    if (workerPool != nullptr && workerPool->getThreadCount() > 1)
     {
-        std::cerr << "Invalid number of arguments for facility command" << std::endl;
+        shardCount = std::min<std::size_t>(workerPool->getThreadCount() * 4, configFile.getSize() / MIN_SHARD_BYTES + 1);
     }
-}
-
-// Handle plan command
-void Simulation::handlePlanCommand(const std::vector<std::string> &arguments)
-{
-    if (arguments.size() == 3)
+    vector<ConfigShard> shards(shardCount);
+    const char *shardBegin = data;
+    for (std::size_t i = 0; i < shardCount; i++)
     {
-        Settlement *foundSettlement = nullptr;
+        const char *shardEnd = end;
+        if (i + 1 < shardCount)
+        {
+            shardEnd = std::max(shardBegin, data + configFile.getSize() / shardCount * (i + 1));
+            shardEnd = findLineEnd(shardEnd, end);
+            shardEnd = shardEnd == end ? end : shardEnd + 1;
+        }
+        shards[i].begin = shardBegin;
+        shards[i].end = shardEnd;
+        shardBegin = shardEnd;
+    }
 
-        // Standard for loop to iterate through settlements
-        for (size_t i = 0; i < settlements.size(); ++i)
+    if (shardCount > 1)
+    {
+        workerPool->parallelFor(shardCount, 1, [&shards](int begin, int last)
         {
-            if (settlements[i]->getName() == arguments[1])
+            for (int i = begin; i < last; i++)
             {
-                foundSettlement = settlements[i];
-                break; // Exit loop as we found the matching settlement
+                parseShard(shards[i]);
             }
-        }
+        });
+    }
+    else
+    {
+        parseShard(shards[0]);
+    }
 
-        if (foundSettlement)
+    // Merge settlements and facility types in file order
+    std::size_t settlementTotal = settlements.size();
+    std::size_t facilityTotal = facilityCatalog->size();
+    for (const ConfigShard &shard : shards)
+    {
+        settlementTotal += shard.settlements.size();
+        facilityTotal += shard.facilities.size();
+    }
+    settlements.reserve(settlementTotal);
+    settlementIndex.reserve(settlementTotal);
+    FacilityCatalog &catalog = getFacilityCatalogForUpdate();
+    catalog.reserve(facilityTotal);
+    vector<std::size_t> settlementBase(shardCount);
+    for (std::size_t i = 0; i < shardCount; i++)
+    {
+        settlementBase[i] = settlements.size();
+        for (Settlement *settlement : shards[i].settlements)
         {
-            SelectionPolicy *policy = createSelectionPolicy(arguments[2]);
-            plans.emplace_back(planCounter++, *foundSettlement, policy, facilitiesOptions);
+            addSettlement(settlement);
         }
-        else
+        for (const FacilityType &facility : shards[i].facilities)
         {
-            std::cerr << "Settlement not found for plan: " << arguments[1] << std::endl;
+            catalog.push_back(facility);
         }
     }
-    else
+
+    // Then plans and messages. A plan only sees settlements defined above it;
+    // the index points at the first settlement with a name, so if that one
+    // comes later there is no earlier one either.
+    for (std::size_t i = 0; i < shardCount; i++)
     {
-        std::cerr << "Invalid number of arguments for plan command" << std::endl;
+        for (const ConfigRecord &record : shards[i].records)
+        {
+            if (!record.isPlan)
+            {
+                std::cerr << record.text << std::endl;
+                continue;
+            }
+            int found = settlementIndex.find(record.text);
+            if (found != -1 && static_cast<std::size_t>(found) < settlementBase[i] + record.settlementsBefore)
+            {
+                SelectionPolicy *policy = createSelectionPolicy(record.policy);
+                plans.push_back(new Plan(planCounter++, settlements[found], policy));
+            }
+            else
+            {
+                std::cerr << "Settlement not found for plan: " << record.text << std::endl;
+            }
+        }
     }
+    planCounter = plans.size();
 }
 
 // Start function
@@ -392,7 +396,7 @@ void Simulation::start()
     isRunning = true;
     std::string action = "";
 
-    std::cout << "Simulation is running!" << std::endl;
+    std::cout << "Simulation is running!" << '\n';
 
     while (true)
     {
@@ -401,31 +405,163 @@ void Simulation::start()
         if (action == "close")
         {
             close();
-            std::cout << "Simulation finished." << std::endl;
+            std::cout << "Simulation finished." << '\n';
             break; 
         }
 
         actionHandler(action);
     }
-    delete backupSim;
+    delete snapshotStore;
+    snapshotStore = nullptr;
 
     isRunning = false; 
 }
 
+// Batch mode: run the commands from a script or piped input without prompts,
+// until "close" or the end of the input, then report the throughput on stderr.
+// With quiet set, only the final plan statuses are printed.
+void Simulation::runBatch(std::istream &commands, bool quiet)
+{
+    isRunning = true;
+    std::string action;
+    std::size_t commandCount = 0;
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    std::cout << "Simulation is running!" << '\n';
+    std::streambuf *output = std::cout.rdbuf();
+    if (quiet)
+    {
+        std::cout.rdbuf(nullptr); // writes to a stream without a buffer are dropped
+    }
+    while (std::getline(commands, action))
+    {
+        commandCount++;
+        if (action == "close")
+        {
+            break;
+        }
+        actionHandler(action);
+    }
+    std::cout.rdbuf(output); // also clears the error state set while quiet
+    close();
+    std::cout << "Simulation finished." << '\n';
+    std::cout.flush();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << "Commands: " << commandCount << ", Time: " << seconds << " s, Commands per second: "
+              << (seconds > 0 ? static_cast<std::size_t>(commandCount / seconds) : commandCount) << std::endl;
+    delete snapshotStore;
+    snapshotStore = nullptr;
+
+    isRunning = false;
+}
+
+namespace
+{
+    // A plan's scores and status before it is stepped
+    struct PlanMark
+    {
+        PlanMark(const Plan &plan, unsigned long long latestRestore)
+            : life_quality_score(plan.getlifeQualityScore()), economy_score(plan.getEconomyScore()),
+              environment_score(plan.getEnvironmentScore()), status(plan.getStatus(latestRestore)) {}
+        bool differs(const Plan &plan, unsigned long long latestRestore) const
+        {
+            return life_quality_score != plan.getlifeQualityScore() || economy_score != plan.getEconomyScore() ||
+                   environment_score != plan.getEnvironmentScore() || status != plan.getStatus(latestRestore);
+        }
+        int life_quality_score, economy_score, environment_score;
+        PlanStatus status;
+    };
+}
+
+// Tells the indexes built so far which plans changed
+void Simulation::markPlansChanged(const vector<int> &planIds)
+{
+    leaderboard.markChanged(planIds);
+    planIndex.markChanged(planIds);
+}
+
 void Simulation::step()
 {
-    for (Plan &element : plans)
+    HotPathStats::Timer timer(HotPathStats::Probe::SIMULATION_STEP);
+    HotPathStats::addSimulatedSteps(1);
+    vector<int> changed;
+    for (std::size_t i = 0; i < plans.size(); i++)
     {
-        element.step();
+        Plan &plan = getMutablePlan(i);
+        PlanMark before(plan, latestRestore);
+        plan.step(*facilityCatalog);
+        if ((leaderboard.isBuilt() || planIndex.isBuilt()) && before.differs(plan, latestRestore))
+        {
+            changed.push_back(i);
+        }
     }
+    markPlansChanged(changed);
+}
+
+// Advance every plan by numOfSteps. Plans never affect each other, so each one
+// jumps straight between its own events instead of ticking in lockstep.
+void Simulation::step(int numOfSteps)
+{
+    HotPathStats::Timer timer(HotPathStats::Probe::SIMULATION_STEP);
+    HotPathStats::addSimulatedSteps(numOfSteps);
+    // Plans whose scores or status moved, for the indexes that have been built
+    const bool trackChanges = leaderboard.isBuilt() || planIndex.isBuilt();
+    vector<int> changed;
+    if (workerPool == nullptr || workerPool->getThreadCount() < 2 || plans.size() < 2)
+    {
+        for (std::size_t i = 0; i < plans.size(); i++)
+        {
+            Plan &plan = getMutablePlan(i);
+            PlanMark before(plan, latestRestore);
+            plan.advance(numOfSteps, *facilityCatalog);
+            if (trackChanges && before.differs(plan, latestRestore))
+            {
+                changed.push_back(i);
+            }
+        }
+        markPlansChanged(changed);
+        return;
+    }
+
+    // Plans shared with a backup are copied by the workers; the list itself must be ours first
+    plans.detach();
+    // Small chunks so threads that drew cheap plans (villages) pick up more work
+    int chunkSize = std::max<int>(1, plans.size() / (workerPool->getThreadCount() * 8));
+    std::mutex changedMutex;
+    workerPool->parallelFor(plans.size(), chunkSize, [this, numOfSteps, trackChanges, &changed, &changedMutex](int begin, int end)
+    {
+        vector<int> changedHere;
+        for (int i = begin; i < end; i++)
+        {
+            Plan &plan = getMutablePlan(i);
+            PlanMark before(plan, latestRestore);
+            plan.advance(numOfSteps, *facilityCatalog);
+            if (trackChanges && before.differs(plan, latestRestore))
+            {
+                changedHere.push_back(i);
+            }
+        }
+        if (!changedHere.empty())
+        {
+            std::lock_guard<std::mutex> lock(changedMutex);
+            changed.insert(changed.end(), changedHere.begin(), changedHere.end());
+        }
+    });
+    markPlansChanged(changed);
+}
+
+void Simulation::setWorkerPool(WorkerPool *pool)
+{
+    workerPool = pool;
 }
 
 // Stop function
 void Simulation::close()
 {
     isRunning = false;
-    for (Plan &element : plans){
-        PrintPlanStatus planPrint = PrintPlanStatus(element.getPlanId());
+    for (std::size_t i = 0; i < plans.size(); i++){
+        PrintPlanStatus planPrint = PrintPlanStatus(plans[i].getPlanId());
         planPrint.act(*this);
     }
 }
@@ -445,76 +581,106 @@ SelectionPolicy *Simulation::createSelectionPolicy(const std::string &policyType
         return new NaiveSelection();
     }
 }
-Plan &Simulation::getPlan(const int planID)
+const Plan &Simulation::getPlan(const int planID) const
 {
-    // Check if the planID is within valid bounds
-    if (planID < 0 ||  static_cast<std::size_t>(planID) >= plans.size())
+    if (!isPlanIdExsits(planID))
     {
-        std::cout << "Invalid plan ID" << std::endl;
+        throw std::runtime_error("Invalid plan ID: " + std::to_string(planID));
     }
-    // Return the plan by reference
     return plans[planID];
 }
-Settlement &Simulation::getSettlement(const string &settlementName)
+Plan &Simulation::getPlanForUpdate(const int planID)
 {
-    for (Settlement *set : settlements)
+    if (!isPlanIdExsits(planID))
     {
-        if (set->getName() == settlementName)
-        {
-            return *set;
-        }
+        throw std::runtime_error("Invalid plan ID: " + std::to_string(planID));
     }
-    throw std::runtime_error("Settlement not found: " + settlementName);
+    planIndex.markChanged(vector<int>(1, planID)); // the caller may change its policy
+    return getMutablePlan(planID);
+}
+
+// Every change to a plan goes through here, so a plan restored busy picks up
+// as available before anything else happens to it (see Plan::getStatus)
+Plan &Simulation::getMutablePlan(std::size_t index)
+{
+    Plan &plan = plans.getMutable(index);
+    plan.resume(latestRestore);
+    return plan;
+}
+
+unsigned long long Simulation::getLatestRestore() const
+{
+    return latestRestore;
+}
+const vector<FacilityType> &Simulation::getFacilitiesOptions() const
+{
+    return facilityCatalog->getTypes();
+}
+// The catalog is shared with backups until it changes. Copying it only shares
+// its storage, which later additions extend in place
+FacilityCatalog &Simulation::getFacilityCatalogForUpdate()
+{
+    if (facilityCatalog.use_count() > 1)
+    {
+        facilityCatalog = std::make_shared<FacilityCatalog>(*facilityCatalog);
+    }
+    return *facilityCatalog;
+}
+const Settlement *Simulation::findSettlement(const string &settlementName) const
+{
+    int found = settlementIndex.find(settlementName);
+    if (found == -1)
+    {
+        return nullptr;
+    }
+    return &settlements[found];
+}
+const Settlement &Simulation::getSettlement(const string &settlementName)
+{
+    const Settlement *settlement = findSettlement(settlementName);
+    if (settlement == nullptr)
+    {
+        throw std::runtime_error("Settlement not found: " + settlementName);
+    }
+    return *settlement;
 }
 void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy)
 {
-    Plan new_plan = Plan(planCounter, settlement, selectionPolicy, facilitiesOptions);
-    plans.push_back((new_plan));
+    plans.push_back(new Plan(planCounter, settlement, selectionPolicy));
+    leaderboard.markAdded(planCounter);
     planCounter++;
 }
 void Simulation::addAction(BaseAction *action)
 {
-   actionsLog.push_back(action);
+   actionsLog.append(action->getRecord());
+   delete action;
 }
 bool Simulation::addSettlement(Settlement *settlement)
 {
     // asumme that that settlement dosent exsit
+    // The index is shared with backups like the settlements and grows in place with them.
+    // A repeated name keeps pointing at the first settlement, as the linear scan did
+    settlementIndex.push_back(settlement->getName());
     settlements.push_back(settlement);
     return true;
 }
 
 bool Simulation::isSettlementExists(const string &settlementName)
 {
-    for (Settlement *set : settlements)
-    {
-        if (set->getName() == settlementName)
-        {
-            return true;
-        }
-    }
-    return false;
+    return findSettlement(settlementName) != nullptr;
 }
-bool Simulation::isPlanIdExsits(const int planID)
+// Plans are never removed and ids are handed out in order, so a plan's id is its index
+bool Simulation::isPlanIdExsits(const int planID) const
 {
-    for (Plan &element : plans)
-    {
-        if (element.getPlanId() == planID)
-        {
-            return true;
-        }
-    }
-    return false;
+    return planID >= 0 && static_cast<std::size_t>(planID) < plans.size();
 }
-bool Simulation::addFacility(FacilityType facility)
+bool Simulation::addFacility(const FacilityType &facility)
 {
-    for (FacilityType fac : facilitiesOptions)
+    if (facilityCatalog->find(facility.getName()) != -1)
     {
-        if (fac.getName() == facility.getName())
-        {
-            return false;
-        }
+        return false;
     }
-    facilitiesOptions.push_back(facility);
+    getFacilityCatalogForUpdate().push_back(facility);
     return true;
 }
 
@@ -529,164 +695,435 @@ std::vector<std::string> Simulation::parseToWords(const std::string& input) {
     return words;
 }
 
-// Create an action handler
-void Simulation::actionHandler(const std::string &action)
+namespace
 {
-    std::vector<std::string> words = parseToWords(action);
-    if (words[0] == "log")
+    // The longest command (facility) has 7 words; one more is kept so longer lines are still counted
+    const std::size_t MAX_COMMAND_ARGUMENTS = 8;
+
+    // Builds the action for one command, runs it and returns it for the log
+    typedef BaseAction *(*CommandHandler)(Simulation &simulation, const Auxiliary::Token *words, std::size_t count);
+
+    // Thrown by parseNumber only, so errors from running an action aren't taken for bad input
+    class InvalidNumber : public std::runtime_error
     {
-        PrintActionsLog printLog = PrintActionsLog();
-        printLog.act(*this);
-        BaseAction *clonedRestore = printLog.clone();
-        actionsLog.push_back(clonedRestore);
-    }
-   else if (words[0] == "settlement")
+    public:
+        explicit InvalidNumber(const string &word) : std::runtime_error("Invalid number: " + word) {}
+    };
+
+    // Handlers read every number before they allocate their action
+    int parseNumber(const Auxiliary::Token &word)
     {
-        if (!isSettlementExists(words[1])){
-        if (words[2] == "0")
+        try
         {
-            AddSettlement settlemntToBeAdded = AddSettlement(words[1], SettlementType::VILLAGE);
-            settlemntToBeAdded.act(*this);
-            BaseAction *clonedRestore = settlemntToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            return Auxiliary::parseInt(word);
         }
-        else if (words[2] == "1")
+        catch (const std::logic_error &) // not a number, or out of range
         {
-            AddSettlement settlemntToBeAdded = AddSettlement(words[1], SettlementType::CITY);
-            settlemntToBeAdded.act(*this);
-            BaseAction *clonedRestore = settlemntToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            throw InvalidNumber(word.toString());
         }
-        else if (words[2] == "2")
+    }
+
+    string getSnapshotName(const Auxiliary::Token *words, std::size_t count)
+    {
+        return count > 1 ? words[1].toString() : "default";
+    }
+
+    BaseAction *runBackup(Simulation &simulation, const Auxiliary::Token *words, std::size_t count)
+    {
+        BaseAction *action = new BackupSimulation(getSnapshotName(words, count));
+        action->act(simulation);
+        return action;
+    }
+
+    BaseAction *runRestore(Simulation &simulation, const Auxiliary::Token *words, std::size_t count)
+    {
+        BaseAction *action = new RestoreSimulation(getSnapshotName(words, count));
+        action->act(simulation);
+        return action;
+    }
+
+    // log | log tail <count> | log from <first> count <count>
+    BaseAction *runLog(Simulation &simulation, const Auxiliary::Token *words, std::size_t count)
+    {
+        BaseAction *action;
+        if (count == 1)
         {
-            AddSettlement settlemntToBeAdded = AddSettlement(words[1], SettlementType::METROPOLIS);
-            settlemntToBeAdded.act(*this);
-            BaseAction *clonedRestore = settlemntToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            action = new PrintActionsLog();
         }
-        else {
-            AddSettlement settlemntToBeAdded = AddSettlement(words[1], SettlementType::CITY);
-            settlemntToBeAdded.errorChange();
-            BaseAction *clonedRestore = settlemntToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+        else if (words[1].equals("tail") && count >= 3)
+        {
+            const int tail = parseNumber(words[2]);
+            action = new PrintActionsLog(tail);
+        }
+        else if (words[1].equals("from") && count >= 5 && words[3].equals("count"))
+        {
+            const int from = parseNumber(words[2]);
+            const int entries = parseNumber(words[4]);
+            action = new PrintActionsLog(from, entries);
         }
+        else if (words[1].equals("tail") || words[1].equals("from"))
+        {
+            std::cout << "--Missing arguments !!-- Type again" << '\n';
+            return nullptr;
         }
-        else{
-            AddSettlement settlemntToBeAdded = AddSettlement(words[1], SettlementType::CITY);
-            settlemntToBeAdded.errorChange();
-            BaseAction *clonedRestore = settlemntToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+        else
+        {
+            std::cout << "--Unrecognized action !!-- Type again" << '\n';
+            return nullptr;
         }
+        action->act(simulation);
+        return action;
     }
-    else if (words[0] == "restore")
-    {
-        RestoreSimulation restoreToDo = RestoreSimulation();
-        restoreToDo.act(*this);
-        BaseAction *clonedRestore = restoreToDo.clone();
-        actionsLog.push_back(clonedRestore);
 
+    BaseAction *runSettlement(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
+    {
+        const string settlementName = words[1].toString();
+        AddSettlement *action;
+        if (simulation.isSettlementExists(settlementName))
+        {
+            action = new AddSettlement(settlementName, SettlementType::CITY);
+            action->errorChange();
+        }
+        else if (words[2].equals("0"))
+        {
+            action = new AddSettlement(settlementName, SettlementType::VILLAGE);
+            action->act(simulation);
+        }
+        else if (words[2].equals("1"))
+        {
+            action = new AddSettlement(settlementName, SettlementType::CITY);
+            action->act(simulation);
+        }
+        else if (words[2].equals("2"))
+        {
+            action = new AddSettlement(settlementName, SettlementType::METROPOLIS);
+            action->act(simulation);
+        }
+        else
+        {
+            action = new AddSettlement(settlementName, SettlementType::CITY);
+            action->errorChange();
+        }
+        return action;
     }
-    else if (words[0] == "facility")
+
+    BaseAction *runFacility(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
     {
-        if (words[2] == "0")
+        // Numbers first: a bad one throws before anything is allocated
+        const int price = parseNumber(words[3]);
+        const int lifeQualityScore = parseNumber(words[4]);
+        const int economyScore = parseNumber(words[5]);
+        const int environmentScore = parseNumber(words[6]);
+        const string facilityName = words[1].toString();
+        AddFacility *action;
+        if (words[2].equals("0"))
+        {
+            action = new AddFacility(facilityName, FacilityCategory::LIFE_QUALITY, price, lifeQualityScore, economyScore, environmentScore);
+            action->act(simulation);
+        }
+        else if (words[2].equals("1"))
         {
-            AddFacility faccilityToBeAdded = AddFacility(words[1], FacilityCategory::LIFE_QUALITY, std::stoi(words[3]), std::stoi(words[4]), std::stoi(words[5]), std::stoi(words[6]));
-            faccilityToBeAdded.act(*this);
-            BaseAction *clonedRestore = faccilityToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            action = new AddFacility(facilityName, FacilityCategory::ECONOMY, price, lifeQualityScore, economyScore, environmentScore);
+            action->act(simulation);
         }
-       else if (words[2] == "1")
+        else if (words[2].equals("2"))
         {
-            AddFacility faccilityToBeAdded = AddFacility(words[1], FacilityCategory::ECONOMY, std::stoi(words[3]), std::stoi(words[4]), std::stoi(words[5]), std::stoi(words[6]));
-            faccilityToBeAdded.act(*this);
-            BaseAction *clonedRestore = faccilityToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            action = new AddFacility(facilityName, FacilityCategory::ENVIRONMENT, price, lifeQualityScore, economyScore, environmentScore);
+            action->act(simulation);
         }
-        else if (words[2] == "2")
+        else
         {
-            AddFacility faccilityToBeAdded = AddFacility(words[1], FacilityCategory::ENVIRONMENT, std::stoi(words[3]), std::stoi(words[4]), std::stoi(words[5]), std::stoi(words[6]));
-            faccilityToBeAdded.act(*this);
-            BaseAction *clonedRestore = faccilityToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+            action = new AddFacility(facilityName, FacilityCategory::ENVIRONMENT, price, lifeQualityScore, economyScore, environmentScore);
+            action->errorFacilityCatagory();
         }
-        else {
-            AddFacility faccilityToBeAdded = AddFacility(words[1], FacilityCategory::ENVIRONMENT, std::stoi(words[3]), std::stoi(words[4]), std::stoi(words[5]), std::stoi(words[6]));
-            faccilityToBeAdded.errorFacilityCatagory();
-            BaseAction *clonedRestore = faccilityToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+        return action;
+    }
+
+    BaseAction *runPlan(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
+    {
+        BaseAction *action = new AddPlan(words[1].toString(), words[2].toString());
+        action->act(simulation);
+        return action;
+    }
+
+    BaseAction *runMemory(Simulation &simulation, const Auxiliary::Token *, std::size_t)
+    {
+        BaseAction *action = new PrintMemoryStats();
+        action->act(simulation);
+        return action;
+    }
+
+    BaseAction *runSnapshots(Simulation &simulation, const Auxiliary::Token *, std::size_t)
+    {
+        BaseAction *action = new PrintSnapshots();
+        action->act(simulation);
+        return action;
+    }
+
+    // stats | stats reset
+    BaseAction *runStats(Simulation &simulation, const Auxiliary::Token *words, std::size_t count)
+    {
+        if (count >= 2 && !words[1].equals("reset"))
+        {
+            std::cout << "--Unrecognized action !!-- Type again" << '\n';
+            return nullptr;
         }
+        BaseAction *action = new PrintStats(count >= 2);
+        action->act(simulation);
+        return action;
     }
-    else if (words[0] == "plan")
+
+    // top <metric> <count>
+    BaseAction *runTop(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
     {
-            AddPlan planToBeAdded(words[1], words[2]);
-            planToBeAdded.act(*this);
-            BaseAction *clonedRestore = planToBeAdded.clone();
-            actionsLog.push_back(clonedRestore);
+        const int count = parseNumber(words[2]);
+        BaseAction *action = new TopPlans(words[1].toString(), count);
+        action->act(simulation);
+        return action;
     }
 
-    else if (words[0] == "backup")
+    // query <count|ids|stats> [<field><op><value>]...
+    BaseAction *runQuery(Simulation &simulation, const Auxiliary::Token *words, std::size_t count)
     {
-        BackupSimulation backupToDo = BackupSimulation();
-        backupToDo.act(*this);
-        BaseAction *clonedRestore = backupToDo.clone();
-        actionsLog.push_back(clonedRestore);
+        vector<string> predicates;
+        for (std::size_t i = 2; i < count; i++)
+        {
+            predicates.push_back(words[i].toString());
+        }
+        BaseAction *action = new QueryPlans(words[1].toString(), predicates);
+        action->act(simulation);
+        return action;
     }
 
-    else if (words[0] == "planStatus")
+    BaseAction *runPlanStatus(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
     {
-        PrintPlanStatus planStatusToBeAdded = PrintPlanStatus(std::stoi(words[1]));
-        planStatusToBeAdded.act(*this);
-        BaseAction *clonedRestore = planStatusToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        const int planId = parseNumber(words[1]);
+        BaseAction *action = new PrintPlanStatus(planId);
+        action->act(simulation);
+        return action;
     }
-    else if (words[0] == "step")
+
+    BaseAction *runStep(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
     {
-        SimulateStep simulateStepToBeAdded = SimulateStep(std::stoi(words[1]));
-        simulateStepToBeAdded.act(*this);
-        BaseAction *clonedRestore = simulateStepToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        const int numOfSteps = parseNumber(words[1]);
+        BaseAction *action = new SimulateStep(numOfSteps);
+        action->act(simulation);
+        return action;
     }
-    else if (words[0] == "changePlanPoliciy")
+
+    BaseAction *runChangePlanPolicy(Simulation &simulation, const Auxiliary::Token *words, std::size_t)
     {
-        ChangePlanPolicy changePlanPolicyToBeAdded = ChangePlanPolicy(std::stoi(words[1]), words[2]);
-        changePlanPolicyToBeAdded.act(*this);
-        BaseAction *clonedRestore = changePlanPolicyToBeAdded.clone();
-        actionsLog.push_back(clonedRestore);
+        const int planId = parseNumber(words[1]);
+        BaseAction *action = new ChangePlanPolicy(planId, words[2].toString());
+        action->act(simulation);
+        return action;
     }
-    else {
-         std::cout << "--Unrecognized action !!-- Type again" << std::endl;
+
+    struct Command
+    {
+        const char *name;
+        std::size_t minWords; // including the command itself
+        CommandHandler handler;
+    };
+
+    const Command COMMANDS[] = {
+        {"log", 1, runLog},
+        {"settlement", 3, runSettlement},
+        {"restore", 1, runRestore},
+        {"facility", 7, runFacility},
+        {"plan", 3, runPlan},
+        {"memory", 1, runMemory},
+        {"backup", 1, runBackup},
+        {"snapshots", 1, runSnapshots},
+        {"stats", 1, runStats},
+        {"top", 3, runTop},
+        {"query", 2, runQuery},
+        {"planStatus", 2, runPlanStatus},
+        {"step", 2, runStep},
+        {"changePlanPoliciy", 3, runChangePlanPolicy},
+    };
+
+    // Open-addressing hash table over COMMANDS, built once. A lookup hashes
+    // the word in place and compares it with at most a couple of names.
+    class CommandTable
+    {
+    public:
+        CommandTable() : slots()
+        {
+            for (const Command &command : COMMANDS)
+            {
+                std::size_t slot = hash(command.name, std::strlen(command.name));
+                while (slots[slot] != nullptr)
+                {
+                    slot = (slot + 1) % SLOT_COUNT;
+                }
+                slots[slot] = &command;
+            }
+        }
+
+        const Command *find(const Auxiliary::Token &word) const
+        {
+            for (std::size_t slot = hash(word.data, word.length); slots[slot] != nullptr; slot = (slot + 1) % SLOT_COUNT)
+            {
+                if (word.equals(slots[slot]->name))
+                {
+                    return slots[slot];
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        static const std::size_t SLOT_COUNT = 32; // more than twice the number of commands
+
+        static std::size_t hash(const char *text, std::size_t length)
+        {
+            std::size_t value = 2166136261u; // FNV-1a
+            for (std::size_t i = 0; i < length; i++)
+            {
+                value = (value ^ static_cast<unsigned char>(text[i])) * 16777619u;
+            }
+            return value % SLOT_COUNT;
+        }
+
+        const Command *slots[SLOT_COUNT];
+    };
+
+    const CommandTable &getCommandTable()
+    {
+        static const CommandTable table;
+        return table;
     }
 }
 
-void Simulation::printLog() const
+// Create an action handler. The command is split in place, looked up in the
+// command table, and its action is built once, run, and recorded in the log.
+void Simulation::actionHandler(const std::string &action)
 {
-    for (BaseAction *action : actionsLog)
+    Auxiliary::Token words[MAX_COMMAND_ARGUMENTS];
+    std::size_t count = Auxiliary::splitArguments(action.data(), action.data() + action.size(), words, MAX_COMMAND_ARGUMENTS);
+    if (count == 0)
+    {
+        return; // empty line
+    }
+
+    const Command *command = getCommandTable().find(words[0]);
+    if (command == nullptr)
+    {
+        std::cout << "--Unrecognized action !!-- Type again" << '\n';
+        return;
+    }
+    if (count < command->minWords)
+    {
+        std::cout << "--Missing arguments !!-- Type again" << '\n';
+        return;
+    }
+
+    BaseAction *done;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    try
+    {
+        done = command->handler(*this, words, count);
+    }
+    catch (const InvalidNumber &)
     {
-        std::cout << action->toString() << std::endl;
+        std::cout << "--Invalid number !!-- Type again" << '\n';
+        return;
+    }
+    if (done != nullptr)
+    {
+        ActionRecord record = done->getRecord();
+        HotPathStats::recordAction(record.code, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+        actionsLog.append(record);
+        delete done;
     }
 }
 
-void Simulation::backup()
+void Simulation::printLog() const
 {
-    // If there's an existing backup, delete it to avoid memory leaks
-    if (backupSim != nullptr)
+    actionsLog.print(std::cout, actionsLog.getBegin(), actionsLog.getEnd());
+}
+
+// Entries are numbered from 0 for the first action of the session
+void Simulation::printLog(std::size_t from, std::size_t count) const
+{
+    actionsLog.print(std::cout, from, count);
+}
+
+std::size_t Simulation::getLogEnd() const
+{
+    return actionsLog.getEnd();
+}
+
+void Simulation::setLogLimit(std::size_t maxEntries)
+{
+    actionsLog.setLimit(maxEntries);
+}
+
+void Simulation::backup(const string &snapshotName)
+{
+    if (snapshotStore == nullptr)
     {
-        delete backupSim;
+        snapshotStore = new SnapshotStore(0);
     }
-
-    // Create a deep copy of the current simulation and store it in backupSimulation
-    backupSim = new Simulation(*this); // Uses the copy constructor
+    HotPathStats::Timer timer(HotPathStats::Probe::BACKUP);
+    // The snapshot shares all state with this simulation until one side changes it
+    snapshotStore->save(snapshotName, *this);
 }
 
-bool Simulation::restore()
+bool Simulation::restore(const string &snapshotName)
 {
-    if (backupSim == nullptr){
+    if (snapshotStore == nullptr){
       return false; 
     }
-   else {
+    HotPathStats::Timer timer(HotPathStats::Probe::RESTORE);
     // Restore the state from the backup
-    *this = *backupSim; // Uses the copy assignment operator
-   return true; 
-   }
+    if (!snapshotStore->load(snapshotName, *this))
+    {
+        return false;
+    }
+    // Restored plans resume as available. Numbering the restore is enough for
+    // that; each plan catches up when it is next read or changed.
+    latestRestore = ++restoreCount;
+    SlabAllocator::releaseFreeSlabs(); // policies of the state replaced
+    return true;
+}
+
+void Simulation::printSnapshots() const
+{
+    if (snapshotStore == nullptr)
+    {
+        std::cout << "Snapshots: 0" << '\n';
+        return;
+    }
+    snapshotStore->print(std::cout, *this);
+}
+
+int Simulation::getPlanCount() const
+{
+    return plans.size();
+}
+
+void Simulation::getTopPlans(Leaderboard::Metric metric, std::size_t count, vector<int> &planIds)
+{
+    leaderboard.getTop(plans, metric, count, planIds);
+}
+
+void Simulation::queryPlans(const PlanFilter &filter, vector<int> &planIds)
+{
+    planIndex.select(plans, filter, latestRestore, planIds);
+}
+
+// Approximate: log chunks, plans, settlements and the catalog, each shared
+// object visited once for this copy so that MemoryUsage can count it once
+// across all copies
+void Simulation::countMemory(MemoryUsage &usage) const
+{
+    usage.visit(this, sizeof(Simulation));
+    actionsLog.countMemory(usage);
+    plans.countMemory(usage);
+    settlements.countMemory(usage);
+    settlementIndex.countMemory(usage);
+    facilityCatalog->countMemory(usage);
 }
 
@@ -0,0 +1,223 @@
+#include "SlabAllocator.h"
+#include <algorithm>
+#include <new>
+
+thread_local SlabAllocator::Cache *SlabAllocator::localCache = nullptr;
+
+SlabAllocator::SlabAllocator()
+    : caches(), slabs(SIZE_CLASS_COUNT), freeBytesAfterRelease(0), mutex() {}
+
+SlabAllocator::~SlabAllocator()
+{
+    for (const vector<char *> &sizeClassSlabs : slabs)
+    {
+        for (char *slab : sizeClassSlabs)
+        {
+            ::operator delete(slab);
+        }
+    }
+}
+
+SlabAllocator &SlabAllocator::instance()
+{
+    static SlabAllocator allocator;
+    return allocator;
+}
+
+// First allocation or free on this thread: give it empty lists
+SlabAllocator::Cache &SlabAllocator::createLocal()
+{
+    SlabAllocator &allocator = instance();
+    std::unique_ptr<Cache> cache(new Cache());
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+    localCache = cache.get();
+    allocator.caches.push_back(std::move(cache));
+    return *localCache;
+}
+
+// Carve a fresh slab into blocks and push them all on this thread's free list
+void SlabAllocator::refill(SizeClass &sizeClass, std::size_t index)
+{
+    const std::size_t blockSize = (index + 1) * GRANULARITY;
+    char *slab = static_cast<char *>(::operator new(SLAB_SIZE));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slabs[index].push_back(slab);
+    }
+    for (std::size_t offset = 0; offset + blockSize <= SLAB_SIZE; offset += blockSize)
+    {
+        void *block = slab + offset;
+        *static_cast<void **>(block) = sizeClass.freeList;
+        sizeClass.freeList = block;
+        sizeClass.freeBlocks++;
+    }
+}
+
+void *SlabAllocator::allocate(std::size_t size)
+{
+    Cache &cache = local();
+    if (size == 0 || size > MAX_BLOCK_SIZE)
+    {
+        cache.largeAllocations++;
+        return ::operator new(size);
+    }
+    std::size_t index = (size - 1) / GRANULARITY;
+    SizeClass &sizeClass = cache.sizeClasses[index];
+    if (sizeClass.freeList == nullptr)
+    {
+        instance().refill(sizeClass, index);
+    }
+    void *block = sizeClass.freeList;
+    sizeClass.freeList = *static_cast<void **>(block);
+    sizeClass.freeBlocks--;
+    sizeClass.allocations++;
+    return block;
+}
+
+void SlabAllocator::deallocate(void *pointer, std::size_t size)
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+    Cache &cache = local();
+    if (size == 0 || size > MAX_BLOCK_SIZE)
+    {
+        cache.largeFrees++;
+        ::operator delete(pointer);
+        return;
+    }
+    SizeClass &sizeClass = cache.sizeClasses[(size - 1) / GRANULARITY];
+    *static_cast<void **>(pointer) = sizeClass.freeList;
+    sizeClass.freeList = pointer;
+    sizeClass.freeBlocks++;
+    sizeClass.frees++;
+}
+
+// A release walks every free block, so it only runs once the free memory has
+// at least doubled since the last one (and is worth a few slabs); blocks
+// scattered over slabs that stay in use then cost amortized O(1) per free.
+void SlabAllocator::releaseFreeSlabs()
+{
+    SlabAllocator &allocator = instance();
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+    std::size_t freeBytes = 0;
+    for (const std::unique_ptr<Cache> &cache : allocator.caches)
+    {
+        for (std::size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            freeBytes += cache->sizeClasses[i].freeBlocks * (i + 1) * GRANULARITY;
+        }
+    }
+    if (freeBytes < 4 * SLAB_SIZE || freeBytes < 2 * allocator.freeBytesAfterRelease)
+    {
+        return;
+    }
+    freeBytes = 0;
+    for (std::size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+    {
+        freeBytes += allocator.releaseSlabs(i);
+    }
+    allocator.freeBytesAfterRelease = freeBytes;
+}
+
+// Counts the free blocks of every slab of one size class over all threads'
+// lists, frees the slabs whose blocks are all free and drops those blocks
+// from the lists
+std::size_t SlabAllocator::releaseSlabs(std::size_t index)
+{
+    vector<char *> &classSlabs = slabs[index];
+    if (classSlabs.empty())
+    {
+        return 0;
+    }
+    const std::size_t blockSize = (index + 1) * GRANULARITY;
+    std::sort(classSlabs.begin(), classSlabs.end());
+    vector<std::size_t> freeBlocks(classSlabs.size(), 0);
+    for (const std::unique_ptr<Cache> &cache : caches)
+    {
+        for (void *block = cache->sizeClasses[index].freeList; block != nullptr; block = *static_cast<void **>(block))
+        {
+            char *address = static_cast<char *>(block);
+            freeBlocks[std::upper_bound(classSlabs.begin(), classSlabs.end(), address) - classSlabs.begin() - 1]++;
+        }
+    }
+
+    const std::size_t blocksPerSlab = SLAB_SIZE / blockSize;
+    vector<char> released(classSlabs.size(), 0);
+    for (std::size_t i = 0; i < classSlabs.size(); i++)
+    {
+        released[i] = freeBlocks[i] == blocksPerSlab;
+    }
+    // Rebuild each list without the blocks of released slabs, keeping its order
+    std::size_t freeBytes = 0;
+    for (const std::unique_ptr<Cache> &cache : caches)
+    {
+        SizeClass &sizeClass = cache->sizeClasses[index];
+        void **link = &sizeClass.freeList;
+        for (void *block = sizeClass.freeList; block != nullptr; block = *static_cast<void **>(block))
+        {
+            char *address = static_cast<char *>(block);
+            if (released[std::upper_bound(classSlabs.begin(), classSlabs.end(), address) - classSlabs.begin() - 1])
+            {
+                sizeClass.freeBlocks--;
+                continue;
+            }
+            *link = block;
+            link = static_cast<void **>(block);
+        }
+        *link = nullptr;
+        freeBytes += sizeClass.freeBlocks * blockSize;
+    }
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < classSlabs.size(); i++)
+    {
+        if (released[i])
+        {
+            ::operator delete(classSlabs[i]);
+        }
+        else
+        {
+            classSlabs[kept++] = classSlabs[i];
+        }
+    }
+    classSlabs.resize(kept);
+    return freeBytes;
+}
+
+void SlabAllocator::printStats(std::ostream &out)
+{
+    SlabAllocator &allocator = instance();
+    std::lock_guard<std::mutex> lock(allocator.mutex);
+    Cache total = Cache();
+    for (const std::unique_ptr<Cache> &cache : allocator.caches)
+    {
+        for (std::size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+        {
+            total.sizeClasses[i].allocations += cache->sizeClasses[i].allocations;
+            total.sizeClasses[i].frees += cache->sizeClasses[i].frees;
+        }
+        total.largeAllocations += cache->largeAllocations;
+        total.largeFrees += cache->largeFrees;
+    }
+    std::size_t live = total.largeAllocations - total.largeFrees;
+    std::size_t slabCount = 0;
+    out << "Pool allocator statistics:\n";
+    for (std::size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+    {
+        const SizeClass &sizeClass = total.sizeClasses[i];
+        if (sizeClass.allocations == 0 && allocator.slabs[i].empty())
+        {
+            continue;
+        }
+        slabCount += allocator.slabs[i].size();
+        live += sizeClass.allocations - sizeClass.frees;
+        out << "BlockSize: " << (i + 1) * GRANULARITY
+            << ", Allocations: " << sizeClass.allocations
+            << ", Frees: " << sizeClass.frees
+            << ", Live: " << sizeClass.allocations - sizeClass.frees
+            << ", Slabs: " << allocator.slabs[i].size() << "\n";
+    }
+    out << "LargeAllocations: " << total.largeAllocations << ", LargeFrees: " << total.largeFrees << "\n";
+    out << "LiveObjects: " << live << ", ReservedBytes: " << slabCount * SLAB_SIZE << "\n";
+}
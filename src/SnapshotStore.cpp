@@ -0,0 +1,124 @@
+#include "SnapshotStore.h"
+#include "Simulation.h"
+#include "SlabAllocator.h"
+
+SnapshotStore::SnapshotStore(std::size_t memoryBudget)
+    : snapshots(), memoryBudget(memoryBudget), useCounter(0), usage() {}
+
+SnapshotStore::~SnapshotStore()
+{
+    for (Snapshot &snapshot : snapshots)
+    {
+        delete snapshot.simulation;
+    }
+}
+
+// Saving under an existing name replaces that snapshot
+void SnapshotStore::save(const string &name, const Simulation &simulation)
+{
+    Simulation *copy = new Simulation(simulation); // shares all state with the live simulation
+    if (memoryBudget != 0)
+    {
+        usage.setMode(MemoryUsage::Mode::ADD);
+        copy->countMemory(usage);
+    }
+    bool replaced = false;
+    for (Snapshot &snapshot : snapshots)
+    {
+        if (snapshot.name == name)
+        {
+            if (memoryBudget != 0)
+            {
+                usage.setMode(MemoryUsage::Mode::REMOVE);
+                snapshot.simulation->countMemory(usage);
+            }
+            delete snapshot.simulation;
+            snapshot.simulation = copy;
+            snapshot.lastUsed = ++useCounter;
+            replaced = true;
+            break;
+        }
+    }
+    if (!replaced)
+    {
+        Snapshot snapshot = {name, copy, ++useCounter};
+        snapshots.push_back(snapshot);
+    }
+    enforceBudget(name, simulation);
+    SlabAllocator::releaseFreeSlabs(); // policies of replaced or evicted snapshots
+}
+
+bool SnapshotStore::load(const string &name, Simulation &simulation)
+{
+    for (Snapshot &snapshot : snapshots)
+    {
+        if (snapshot.name == name)
+        {
+            simulation = *snapshot.simulation; // shares the snapshot's state
+            snapshot.lastUsed = ++useCounter;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Objects the live run holds are set aside while evicting, as evicting would
+// not free them. Each eviction takes its snapshot's objects off the running
+// count, costing one pass over that snapshot.
+void SnapshotStore::enforceBudget(const string &keep, const Simulation &live)
+{
+    if (memoryBudget == 0)
+    {
+        return;
+    }
+    usage.setMode(MemoryUsage::Mode::EXCLUDE);
+    live.countMemory(usage);
+    while (snapshots.size() > 1 && usage.getBytes() > memoryBudget)
+    {
+        vector<Snapshot>::iterator oldest = snapshots.end();
+        for (vector<Snapshot>::iterator it = snapshots.begin(); it != snapshots.end(); ++it)
+        {
+            if (it->name != keep && (oldest == snapshots.end() || it->lastUsed < oldest->lastUsed))
+            {
+                oldest = it;
+            }
+        }
+        usage.setMode(MemoryUsage::Mode::REMOVE);
+        oldest->simulation->countMemory(usage);
+        delete oldest->simulation;
+        snapshots.erase(oldest);
+    }
+    usage.setMode(MemoryUsage::Mode::INCLUDE);
+    live.countMemory(usage);
+}
+
+// Counted afresh, as the running count is only kept with a budget set.
+// UnsharedBytes is what evicting that snapshot alone would free; SnapshotBytes
+// is what evicting them all would.
+void SnapshotStore::print(std::ostream &out, const Simulation &live) const
+{
+    MemoryUsage current;
+    for (const Snapshot &snapshot : snapshots)
+    {
+        snapshot.simulation->countMemory(current);
+    }
+    current.setMode(MemoryUsage::Mode::EXCLUDE);
+    live.countMemory(current);
+    for (const Snapshot &snapshot : snapshots)
+    {
+        current.setMode(MemoryUsage::Mode::MEASURE);
+        snapshot.simulation->countMemory(current);
+        out << "Snapshot: " << snapshot.name
+            << ", Plans: " << snapshot.simulation->getPlanCount()
+            << ", UnsharedBytes: " << current.getMeasuredBytes() << "\n";
+    }
+    out << "Snapshots: " << snapshots.size() << ", SnapshotBytes: " << current.getBytes() << ", MemoryBudget: ";
+    if (memoryBudget == 0)
+    {
+        out << "unlimited\n";
+    }
+    else
+    {
+        out << memoryBudget << "\n";
+    }
+}
@@ -0,0 +1,103 @@
+#include "WorkerPool.h"
+
+// The calling thread works too, so numOfThreads - 1 extra threads are started
+WorkerPool::WorkerPool(int numOfThreads)
+    : threads(), mutex(), wakeUp(), finished(), task(nullptr), count(0), chunkSize(1),
+      nextIndex(0), activeWorkers(0), round(0), stopping(false), failure()
+{
+    for (int i = 1; i < numOfThreads; i++)
+    {
+        threads.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+int WorkerPool::getThreadCount() const
+{
+    return threads.size() + 1;
+}
+
+void WorkerPool::parallelFor(int count, int chunkSize, const std::function<void(int, int)> &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        this->chunkSize = chunkSize > 0 ? chunkSize : 1;
+        nextIndex = 0;
+        activeWorkers = threads.size();
+        failure = nullptr;
+        round++;
+    }
+    wakeUp.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return activeWorkers == 0; });
+    this->task = nullptr;
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+void WorkerPool::runChunks()
+{
+    while (true)
+    {
+        int begin = nextIndex.fetch_add(chunkSize);
+        if (begin >= count)
+        {
+            return;
+        }
+        int end = begin + chunkSize < count ? begin + chunkSize : count;
+        try
+        {
+            (*task)(begin, end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+            nextIndex = count; // stop handing out work
+        }
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    unsigned long seenRound = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this, seenRound] { return stopping || round != seenRound; });
+            if (stopping)
+            {
+                return;
+            }
+            seenRound = round;
+        }
+        runChunks();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        finished.notify_one();
+    }
+}
@@ -1,25 +1,143 @@
 #include "Simulation.h"
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
 #include "globals.h"
+#include "WorkerPool.h"
+#include "SnapshotStore.h"
 
 using namespace std;
 
-Simulation *backup = nullptr;
+namespace
+{
+    const char *USAGE = "usage: simulation <config_path> [--threads <count>] [--snapshot-budget <megabytes>] [--log-limit <entries>] "
+                        "[--script <commands_path> | --batch] [--quiet (batch runs only)]";
+
+    struct Options
+    {
+        int numOfThreads = 1;
+        std::size_t snapshotBudget = 0;
+        std::size_t logLimit = 0;
+        string scriptFile = "";
+        bool batch = false;
+        bool quiet = false;
+    };
+
+    // std::stoul wraps a leading minus sign around instead of rejecting it
+    std::size_t parseCount(const string &text)
+    {
+        if (!text.empty() && text[0] == '-')
+        {
+            throw std::invalid_argument(text);
+        }
+        return std::stoul(text);
+    }
+
+    // Throws std::logic_error (from stoi and friends) on a malformed number
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            string option = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (option == "--threads" && hasValue)
+            {
+                // --threads 0 uses every hardware thread
+                options.numOfThreads = std::stoi(argv[++i]);
+                if (options.numOfThreads <= 0)
+                {
+                    options.numOfThreads = std::max(1u, std::thread::hardware_concurrency());
+                }
+            }
+            else if (option == "--snapshot-budget" && hasValue)
+            {
+                options.snapshotBudget = parseCount(argv[++i]) * 1024 * 1024;
+            }
+            else if (option == "--log-limit" && hasValue)
+            {
+                options.logLimit = parseCount(argv[++i]); // 0 keeps the whole log
+            }
+            else if (option == "--script" && hasValue)
+            {
+                options.scriptFile = argv[++i];
+                options.batch = true;
+            }
+            else if (option == "--batch")
+            {
+                options.batch = true; // commands come from stdin
+            }
+            else if (option == "--quiet")
+            {
+                options.quiet = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        // Interactive runs always prompt; --quiet only applies to batch runs
+        return !options.quiet || options.batch;
+    }
+}
 
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        cout << "usage: simulation <config_path>" << endl;
+        cout << USAGE << endl;
         return 0;
     }
     string configurationFile = argv[1];
-    Simulation simulation(configurationFile);
-    simulation.start();
-    if (backup != nullptr)
+    Options options;
+    try
     {
-        delete backup;
-        backup = nullptr;
-    } // ss//s
+        if (!parseOptions(argc, argv, options))
+        {
+            cout << USAGE << endl;
+            return 0;
+        }
+    }
+    catch (const std::logic_error &)
+    {
+        cout << USAGE << endl;
+        return 0;
+    }
+    const string &scriptFile = options.scriptFile;
+    const bool batch = options.batch;
+
+    // Batch runs write through one large stdout buffer instead of flushing per
+    // line. cout stays synced with stdio so that it goes through that buffer,
+    // and is untied from cin so that reading commands doesn't flush it.
+    if (batch)
+    {
+        std::setvbuf(stdout, nullptr, _IOFBF, 1 << 20);
+        cin.tie(nullptr);
+    }
+    std::ifstream script;
+    if (!scriptFile.empty())
+    {
+        script.open(scriptFile);
+        if (!script.is_open())
+        {
+            cerr << "Failed to open script file: " << scriptFile << endl;
+            return 1;
+        }
+    }
+
+    WorkerPool workerPool(options.numOfThreads);
+    Simulation simulation(configurationFile, &workerPool);
+    simulation.setLogLimit(options.logLimit);
+    snapshotStore = new SnapshotStore(options.snapshotBudget);
+    if (batch)
+    {
+        simulation.runBatch(scriptFile.empty() ? cin : script, options.quiet);
+    }
+    else
+    {
+        simulation.start();
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,377 @@
+// Generates a synthetic configuration file and a matching command script for
+// scale testing. Everything is drawn from one seeded mt19937_64 and mapped to
+// ranges by hand, so a seed gives the same scenario with any standard library.
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const char *POLICIES[] = {"naiv", "bal", "eco", "sus"};
+    const char *SETTLEMENT_PREFIXES[] = {"Village", "City", "Metropolis"};
+
+    struct Options
+    {
+        std::uint64_t seed = 1;
+        int settlements[3] = {10, 10, 10}; // per SettlementType
+        int facilities = 100;
+        vector<double> categoryMix = {1, 1, 1}; // life quality, economy, environment
+        int scoreMin = 0;
+        int scoreMax = 5;
+        string scoreDistribution = "uniform";
+        int priceMin = 1;
+        int priceMax = 5;
+        int plansPerSettlement = 1;
+        vector<double> policyMix = {1, 1, 1, 1}; // naiv, bal, eco, sus
+        int rounds = 100;
+        int stepSize = 1;
+        int backupEvery = 0; // rounds; 0 never
+        int restoreEvery = 0;
+        int policyChangeEvery = 0;
+        int statusEvery = 0;
+        bool log = false;
+        string configPath = "";
+        string scriptPath = "";
+    };
+
+    class Random
+    {
+    public:
+        explicit Random(std::uint64_t seed) : engine(seed) {}
+
+        // Uniform in [low, high]
+        int between(int low, int high)
+        {
+            std::uint64_t span = static_cast<std::uint64_t>(static_cast<std::int64_t>(high) - low) + 1;
+            return static_cast<int>(low + static_cast<std::int64_t>(engine() % span));
+        }
+
+        // Uniform in [0, 1)
+        double fraction()
+        {
+            return (engine() >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        // An index drawn with the given relative weights
+        int pick(const vector<double> &weights)
+        {
+            double total = 0;
+            for (double weight : weights)
+            {
+                total += weight;
+            }
+            double point = fraction() * total;
+            for (std::size_t i = 0; i + 1 < weights.size(); i++)
+            {
+                if (point < weights[i])
+                {
+                    return static_cast<int>(i);
+                }
+                point -= weights[i];
+            }
+            return static_cast<int>(weights.size()) - 1;
+        }
+
+    private:
+        std::mt19937_64 engine;
+    };
+
+    int drawScore(Random &random, const Options &options)
+    {
+        if (options.scoreDistribution == "skewed")
+        {
+            // Most facilities score low, a few score high
+            double u = random.fraction();
+            return options.scoreMin + static_cast<int>(u * u * (options.scoreMax - options.scoreMin + 1));
+        }
+        if (options.scoreDistribution == "constant")
+        {
+            return options.scoreMax;
+        }
+        return random.between(options.scoreMin, options.scoreMax);
+    }
+
+    vector<double> parseWeights(const string &text, std::size_t count)
+    {
+        vector<double> weights;
+        std::stringstream stream(text);
+        string item;
+        while (std::getline(stream, item, ','))
+        {
+            weights.push_back(std::stod(item));
+        }
+        double total = 0;
+        for (double weight : weights)
+        {
+            if (weight < 0)
+            {
+                throw std::invalid_argument("negative weight");
+            }
+            total += weight;
+        }
+        if (weights.size() != count || total <= 0)
+        {
+            throw std::invalid_argument("expected " + std::to_string(count) + " comma-separated weights");
+        }
+        return weights;
+    }
+
+    // Facility categories some plan will need a facility of: an eco plan takes
+    // economy facilities and a sus plan environment ones. A config "sus" plan
+    // starts out naive, so sus only appears through policy changes, which may
+    // pick any policy. Empty if there are no plans.
+    vector<int> neededCategories(const Options &options)
+    {
+        vector<int> categories;
+        int plans = (options.settlements[0] + options.settlements[1] + options.settlements[2]) * options.plansPerSettlement;
+        if (plans == 0)
+        {
+            return categories;
+        }
+        if (options.policyMix[2] > 0 || options.policyChangeEvery > 0)
+        {
+            categories.push_back(1);
+        }
+        if (options.policyChangeEvery > 0)
+        {
+            categories.push_back(2);
+        }
+        return categories;
+    }
+
+    // The engine stops on a plan whose policy finds no facility to build, so
+    // reject a catalog that cannot serve every plan; empty if it can
+    string checkCatalog(const Options &options)
+    {
+        const char *names[] = {"life quality", "economy", "environment"};
+        int plans = (options.settlements[0] + options.settlements[1] + options.settlements[2]) * options.plansPerSettlement;
+        vector<int> needed = neededCategories(options);
+        if (plans > 0 && options.facilities < std::max<int>(1, needed.size()))
+        {
+            return "--facilities " + std::to_string(options.facilities) + " is too few for the plans' policies";
+        }
+        for (int category : needed)
+        {
+            if (options.categoryMix[category] <= 0)
+            {
+                return string("--category-mix gives no ") + names[category] + " facilities, which " +
+                       (category == 1 ? "eco" : "sus (after a policy change)") + " plans need";
+            }
+        }
+        return "";
+    }
+
+    // Writes the config and returns the policy every plan starts with, by plan id
+    vector<int> writeConfig(std::ostream &out, const Options &options, Random &random)
+    {
+        out << "# generated by scenario_generator --seed " << options.seed << '\n';
+        out << "# settlement <settlement_name> <settlement_type>\n";
+        for (int type = 0; type < 3; type++)
+        {
+            for (int i = 0; i < options.settlements[type]; i++)
+            {
+                out << "settlement " << SETTLEMENT_PREFIXES[type] << i << ' ' << type << '\n';
+            }
+        }
+        out << "# facility <facility_name> <category> <price> <lifeq_impact> <eco_impact> <env_impact>\n";
+        vector<int> missing = neededCategories(options);
+        for (int i = 0; i < options.facilities; i++)
+        {
+            int category = random.pick(options.categoryMix);
+            if (static_cast<int>(missing.size()) == options.facilities - i &&
+                std::find(missing.begin(), missing.end(), category) == missing.end())
+            {
+                category = missing.back(); // the last facilities go to categories still missing
+            }
+            missing.erase(std::remove(missing.begin(), missing.end(), category), missing.end());
+            int price = random.between(options.priceMin, options.priceMax);
+            int life = drawScore(random, options);
+            int economy = drawScore(random, options);
+            int environment = drawScore(random, options);
+            out << "facility Facility" << i << ' ' << category << ' ' << price << ' ' << life << ' ' << economy << ' ' << environment << '\n';
+        }
+        out << "# plan <settlement_name> <selection_policy>\n";
+        vector<int> policies;
+        for (int type = 0; type < 3; type++)
+        {
+            for (int i = 0; i < options.settlements[type]; i++)
+            {
+                for (int plan = 0; plan < options.plansPerSettlement; plan++)
+                {
+                    int policy = random.pick(options.policyMix);
+                    out << "plan " << SETTLEMENT_PREFIXES[type] << i << ' ' << POLICIES[policy] << '\n';
+                    // Simulation::createSelectionPolicy reads config "sus" as naive
+                    policies.push_back(policy == 3 ? 0 : policy);
+                }
+            }
+        }
+        return policies;
+    }
+
+    // Plans get their ids in config order, so the script can address them by index
+    void writeScript(std::ostream &out, const Options &options, Random &random, vector<int> policies)
+    {
+        vector<int> backedUp = policies;
+        bool hasBackup = false;
+        for (int round = 1; round <= options.rounds; round++)
+        {
+            out << "step " << options.stepSize << '\n';
+            if (options.policyChangeEvery > 0 && round % options.policyChangeEvery == 0 && !policies.empty())
+            {
+                // Always a different policy, so the change is accepted
+                int plan = random.between(0, static_cast<int>(policies.size()) - 1);
+                int policy = (policies[plan] + random.between(1, 3)) % 4;
+                policies[plan] = policy;
+                out << "changePlanPoliciy " << plan << ' ' << POLICIES[policy] << '\n';
+            }
+            if (options.statusEvery > 0 && round % options.statusEvery == 0 && !policies.empty())
+            {
+                out << "planStatus " << random.between(0, static_cast<int>(policies.size()) - 1) << '\n';
+            }
+            if (options.backupEvery > 0 && round % options.backupEvery == 0)
+            {
+                out << "backup\n";
+                backedUp = policies;
+                hasBackup = true;
+            }
+            if (options.restoreEvery > 0 && round % options.restoreEvery == 0 && hasBackup)
+            {
+                out << "restore\n";
+                policies = backedUp;
+            }
+        }
+        if (options.log)
+        {
+            out << "log\n";
+        }
+        out << "close\n";
+    }
+
+    const char *USAGE =
+        "usage: scenario_generator --config <path> [--script <path>] [--seed <n>]\n"
+        "  [--villages <n>] [--cities <n>] [--metropolises <n>] [--plans-per-settlement <n>]\n"
+        "  [--facilities <n>] [--category-mix <life,eco,env>] [--price-range <min> <max>]\n"
+        "  [--score-range <min> <max>] [--score-distribution uniform|skewed|constant]\n"
+        "  [--policy-mix <naiv,bal,eco,sus>] [--rounds <n>] [--step-size <n>]\n"
+        "  [--backup-every <rounds>] [--restore-every <rounds>] [--policy-change-every <rounds>]\n"
+        "  [--status-every <rounds>] [--log]";
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string option = argv[i];
+            int values = argc - i - 1;
+            if (option == "--config" && values >= 1)
+                options.configPath = argv[++i];
+            else if (option == "--script" && values >= 1)
+                options.scriptPath = argv[++i];
+            else if (option == "--seed" && values >= 1)
+                options.seed = std::stoull(argv[++i]);
+            else if (option == "--villages" && values >= 1)
+                options.settlements[0] = std::stoi(argv[++i]);
+            else if (option == "--cities" && values >= 1)
+                options.settlements[1] = std::stoi(argv[++i]);
+            else if (option == "--metropolises" && values >= 1)
+                options.settlements[2] = std::stoi(argv[++i]);
+            else if (option == "--plans-per-settlement" && values >= 1)
+                options.plansPerSettlement = std::stoi(argv[++i]);
+            else if (option == "--facilities" && values >= 1)
+                options.facilities = std::stoi(argv[++i]);
+            else if (option == "--category-mix" && values >= 1)
+                options.categoryMix = parseWeights(argv[++i], 3);
+            else if (option == "--price-range" && values >= 2)
+            {
+                options.priceMin = std::stoi(argv[++i]);
+                options.priceMax = std::stoi(argv[++i]);
+            }
+            else if (option == "--score-range" && values >= 2)
+            {
+                options.scoreMin = std::stoi(argv[++i]);
+                options.scoreMax = std::stoi(argv[++i]);
+            }
+            else if (option == "--score-distribution" && values >= 1)
+                options.scoreDistribution = argv[++i];
+            else if (option == "--policy-mix" && values >= 1)
+                options.policyMix = parseWeights(argv[++i], 4);
+            else if (option == "--rounds" && values >= 1)
+                options.rounds = std::stoi(argv[++i]);
+            else if (option == "--step-size" && values >= 1)
+                options.stepSize = std::stoi(argv[++i]);
+            else if (option == "--backup-every" && values >= 1)
+                options.backupEvery = std::stoi(argv[++i]);
+            else if (option == "--restore-every" && values >= 1)
+                options.restoreEvery = std::stoi(argv[++i]);
+            else if (option == "--policy-change-every" && values >= 1)
+                options.policyChangeEvery = std::stoi(argv[++i]);
+            else if (option == "--status-every" && values >= 1)
+                options.statusEvery = std::stoi(argv[++i]);
+            else if (option == "--log")
+                options.log = true;
+            else
+                return false;
+        }
+        if (options.configPath.empty() || options.facilities < 0 || options.plansPerSettlement < 0 ||
+            options.settlements[0] < 0 || options.settlements[1] < 0 || options.settlements[2] < 0 ||
+            options.priceMin > options.priceMax || options.scoreMin > options.scoreMax || options.stepSize < 1)
+        {
+            return false;
+        }
+        const string &distribution = options.scoreDistribution;
+        return distribution == "uniform" || distribution == "skewed" || distribution == "constant";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+        {
+            cerr << USAGE << endl;
+            return 1;
+        }
+    }
+    catch (const std::logic_error &) // stoi and friends, or a bad weight list
+    {
+        cerr << USAGE << endl;
+        return 1;
+    }
+
+    string problem = checkCatalog(options);
+    if (!problem.empty())
+    {
+        cerr << problem << endl;
+        return 1;
+    }
+
+    Random random(options.seed);
+    std::ofstream config(options.configPath);
+    if (!config.is_open())
+    {
+        cerr << "Failed to open config file: " << options.configPath << endl;
+        return 1;
+    }
+    vector<int> policies = writeConfig(config, options, random);
+    config.close();
+
+    if (!options.scriptPath.empty())
+    {
+        std::ofstream script(options.scriptPath);
+        if (!script.is_open())
+        {
+            cerr << "Failed to open script file: " << options.scriptPath << endl;
+            return 1;
+        }
+        writeScript(script, options, random, policies);
+    }
+    return 0;
+}